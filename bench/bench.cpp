@@ -0,0 +1,383 @@
+#include "generate.hpp"
+#include "solver.hpp"
+#include "timer.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <map>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+struct instance
+{
+    std::string name;
+    std::function< cnf_t() > generate;
+};
+
+struct result
+{
+    std::string name;
+    std::string answer;
+    double seconds = 0;
+    size_t conflicts = 0;
+    size_t propagations = 0;
+    double peak_mb = 0;
+};
+
+struct options_t
+{
+    std::string suite = "quick";
+    unsigned int repeat = 1;
+    size_t max_conflicts = 10000000;
+    const char *save = nullptr;
+    const char *baseline = nullptr;
+    double threshold = 0.2;
+    double min_seconds = 0.05;
+    solver_config config;
+};
+
+[[noreturn]] void usage()
+{
+    std::cerr << "usage: sat-bench [options]\n"
+                 "  --suite=NAME          quick ( default, about ten seconds ) or full\n"
+                 "  --repeat=N            solve each instance N times and keep the\n"
+                 "                        fastest run ( default 1 )\n"
+                 "  --max-conflicts=N     give up on an instance after N conflicts\n"
+                 "  --save=FILE           write the results to FILE\n"
+                 "  --baseline=FILE       compare the times with results saved before\n"
+                 "  --threshold=X         a slowdown by more than X is a regression\n"
+                 "                        ( default 0.2 )\n"
+                 "  --min-seconds=T       instances faster than T in the baseline are\n"
+                 "                        not compared ( default 0.05 )\n"
+                 "  --restarts=POLICY     luby, geometric, glucose or switching\n"
+                 "  --decide=HEURISTIC    vsids, vmtf or mixed\n";
+    std::exit( 1 );
+}
+
+const char *option_value( const char *arg, const char *name )
+{
+    size_t length = std::strlen( name );
+    if ( std::strncmp( arg, name, length ) == 0 && arg[ length ] == '=' )
+        return arg + length + 1;
+    return nullptr;
+}
+
+options_t parse_options( int argc, char **argv )
+{
+    options_t opts;
+    for ( int i = 1; i < argc; i++ )
+    {
+        const char *arg = argv[ i ];
+        const char *value;
+
+        if ( ( value = option_value( arg, "--suite" ) ) )
+            opts.suite = value;
+        else if ( ( value = option_value( arg, "--repeat" ) ) )
+            opts.repeat = std::max( 1, std::atoi( value ) );
+        else if ( ( value = option_value( arg, "--max-conflicts" ) ) )
+            opts.max_conflicts = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--save" ) ) )
+            opts.save = value;
+        else if ( ( value = option_value( arg, "--baseline" ) ) )
+            opts.baseline = value;
+        else if ( ( value = option_value( arg, "--threshold" ) ) )
+            opts.threshold = std::atof( value );
+        else if ( ( value = option_value( arg, "--min-seconds" ) ) )
+            opts.min_seconds = std::atof( value );
+        else if ( ( value = option_value( arg, "--restarts" ) ) )
+        {
+            const char *names[] = { "luby", "geometric", "glucose", "switching" };
+            auto name = std::find_if( std::begin( names ), std::end( names ), [&]( const char *n ) {
+                return std::strcmp( n, value ) == 0; } );
+            if ( name == std::end( names ) )
+                usage();
+            opts.config.restarts = restart_t( name - std::begin( names ) );
+        }
+        else if ( ( value = option_value( arg, "--decide" ) ) )
+        {
+            const char *names[] = { "vsids", "vmtf", "mixed" };
+            auto name = std::find_if( std::begin( names ), std::end( names ), [&]( const char *n ) {
+                return std::strcmp( n, value ) == 0; } );
+            if ( name == std::end( names ) )
+                usage();
+            opts.config.heuristic = decide_t( name - std::begin( names ) );
+        }
+        else
+            usage();
+    }
+
+    if ( opts.suite != "quick" && opts.suite != "full" )
+        usage();
+    return opts;
+}
+
+
+/** The instances of the suite, the same ones on every run since they are
+ *  generated from fixed seeds. */
+std::vector< instance > make_suite( const std::string &suite )
+{
+    bool full = suite == "full";
+    std::vector< instance > instances;
+
+    // The clause counts of the uf / uuf families, at the threshold ratio.
+    const std::pair< unsigned int, size_t > sizes[] = { { 150, 645 }, { 200, 860 }, { 250, 1065 } };
+    unsigned int seeds = full ? 8 : 3;
+    for ( auto [ vars, clauses ] : sizes )
+        for ( unsigned int seed = 1; seed <= seeds; seed++ )
+            instances.push_back( { "rand3-" + std::to_string( vars ) + "-" + std::to_string( seed )
+                                 , [=]{ return random_ksat( vars, clauses, 3, seed ); } } );
+
+    for ( unsigned int seed = 1; seed <= seeds; seed++ )
+        instances.push_back( { "rand5-50-" + std::to_string( seed )
+                             , [=]{ return random_ksat( 50, 1050, 5, seed ); } } );
+
+    for ( unsigned int holes = 7; holes <= ( full ? 10u : 8u ); holes++ )
+        instances.push_back( { "php-" + std::to_string( holes )
+                             , [=]{ return pigeonhole( holes ); } } );
+
+    for ( unsigned int vars = 24; vars <= ( full ? 36u : 28u ); vars += 4 )
+        for ( unsigned int seed = 1; seed <= ( full ? 3u : 1u ); seed++ )
+            instances.push_back( { "parity-" + std::to_string( vars ) + "-" + std::to_string( seed )
+                                 , [=]{ return parity( vars, false, seed ); } } );
+
+    return instances;
+}
+
+
+double peak_mb()
+{
+    rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss / 1024.0;
+}
+
+bool satisfies( const cnf_t &cnf, solver &s )
+{
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+    {
+        bool satisfied = false;
+        for ( lit_t l : cnf.clause( i ) )
+            satisfied |= s.model_value( l ) == val_tt;
+        if ( ! satisfied )
+            return false;
+    }
+    return true;
+}
+
+/** Solves the instance in a fresh solver repeat times, the fastest run
+ *  counts. A model which does not satisfy the formula is reported as
+ *  WRONG. */
+result run( const instance &inst, const options_t &opts )
+{
+    cnf_t cnf = inst.generate();
+
+    result best;
+    best.name = inst.name;
+    for ( unsigned int i = 0; i < opts.repeat; i++ )
+    {
+        solver s( cnf, opts.config );
+        double seconds = 0;
+        sat_t res;
+        {
+            scoped_timer t( &seconds );
+            res = s.solve( {}, opts.max_conflicts );
+        }
+
+        if ( i > 0 && seconds >= best.seconds )
+            continue;
+        best.answer = res == SAT && ! satisfies( cnf, s ) ? "WRONG" : sat_to_str[ res ];
+        best.seconds = seconds;
+        best.conflicts = s.stats.conflicts;
+        best.propagations = s.stats.propagations;
+    }
+    best.peak_mb = peak_mb();
+    return best;
+}
+
+/** Runs the instance in a child process, since the peak memory of a
+ *  process never decreases: in the benchmark itself it would be the peak
+ *  of all the instances so far. The child sends the result through a
+ *  pipe, one which dies is reported as CRASH. */
+result run_in_child( const instance &inst, const options_t &opts )
+{
+    int fds[ 2 ];
+    if ( pipe( fds ) != 0 )
+    {
+        std::cerr << "c cannot create a pipe" << std::endl;
+        std::exit( 1 );
+    }
+
+    fflush( stdout );
+    pid_t pid = fork();
+    if ( pid < 0 )
+    {
+        std::cerr << "c cannot fork" << std::endl;
+        std::exit( 1 );
+    }
+    if ( pid == 0 )
+    {
+        close( fds[ 0 ] );
+        result r = run( inst, opts );
+        std::string line = r.answer + " " + std::to_string( r.seconds ) + " "
+                         + std::to_string( r.conflicts ) + " " + std::to_string( r.propagations )
+                         + " " + std::to_string( r.peak_mb ) + "\n";
+        bool sent = write( fds[ 1 ], line.data(), line.size() ) == ssize_t( line.size() );
+        _exit( sent ? 0 : 1 );
+    }
+
+    close( fds[ 1 ] );
+    std::string line;
+    char buffer[ 256 ];
+    ssize_t count;
+    while ( ( count = read( fds[ 0 ], buffer, sizeof( buffer ) ) ) > 0 )
+        line.append( buffer, count );
+    close( fds[ 0 ] );
+
+    int status = 0;
+    waitpid( pid, &status, 0 );
+
+    result r;
+    r.name = inst.name;
+    char answer[ 16 ];
+    if ( ! WIFEXITED( status ) || WEXITSTATUS( status ) != 0
+      || sscanf( line.c_str(), "%15s %lf %zu %zu %lf", answer, &r.seconds, &r.conflicts
+               , &r.propagations, &r.peak_mb ) != 5 )
+        r.answer = "CRASH";
+    else
+        r.answer = answer;
+    return r;
+}
+
+
+std::map< std::string, result > load( const char *path )
+{
+    std::ifstream in( path );
+    if ( ! in )
+    {
+        std::cerr << "c cannot read " << path << std::endl;
+        std::exit( 1 );
+    }
+
+    std::map< std::string, result > results;
+    result r;
+    while ( in >> r.name >> r.answer >> r.seconds >> r.conflicts >> r.propagations >> r.peak_mb )
+        results[ r.name ] = r;
+    return results;
+}
+
+void save( const char *path, const std::vector< result > &results )
+{
+    std::ofstream out( path );
+    for ( const result &r : results )
+        out << r.name << " " << r.answer << " " << r.seconds << " " << r.conflicts
+            << " " << r.propagations << " " << r.peak_mb << "\n";
+    if ( ! out )
+    {
+        std::cerr << "c cannot write " << path << std::endl;
+        std::exit( 1 );
+    }
+}
+
+double rate( size_t count, double seconds )
+{
+    return seconds > 0 ? count / seconds : 0.0;
+}
+
+
+/** Solves the suite and prints a line per instance. With a baseline, an
+ *  instance whose answer differs, or which got slower by more than the
+ *  threshold, is flagged and makes the exit status 1. */
+int main( int argc, char **argv )
+{
+    options_t opts = parse_options( argc, argv );
+
+    std::map< std::string, result > baseline;
+    if ( opts.baseline )
+        baseline = load( opts.baseline );
+
+    printf( "%-20s %-7s %9s %10s %10s %12s %8s", "instance", "result", "seconds"
+          , "conflicts", "confl/s", "props/s", "peak MB" );
+    if ( opts.baseline )
+        printf( " %9s %8s", "baseline", "change" );
+    printf( "\n" );
+
+    std::vector< result > results;
+    result total;
+    double peak = 0;
+    double baseline_seconds = 0, compared_seconds = 0;
+    int regressions = 0;
+
+    for ( const instance &inst : make_suite( opts.suite ) )
+    {
+        result r = run_in_child( inst, opts );
+        results.push_back( r );
+        peak = std::max( peak, r.peak_mb );
+        total.seconds += r.seconds;
+        total.conflicts += r.conflicts;
+        total.propagations += r.propagations;
+
+        printf( "%-20s %-7s %9.3f %10zu %10.0f %12.0f %8.1f", r.name.c_str(), r.answer.c_str()
+              , r.seconds, r.conflicts, rate( r.conflicts, r.seconds )
+              , rate( r.propagations, r.seconds ), r.peak_mb );
+
+        auto b = baseline.find( r.name );
+        if ( b != baseline.end() )
+        {
+            const result &base = b->second;
+            double change = base.seconds > 0 ? r.seconds / base.seconds - 1 : 0.0;
+            printf( " %9.3f %+7.1f%%", base.seconds, 100 * change );
+
+            bool wrong = r.answer == "WRONG" || r.answer == "CRASH"
+                      || ( r.answer != base.answer && r.answer != "UNKNOWN"
+                                                   && base.answer != "UNKNOWN" );
+            bool compared = base.seconds >= opts.min_seconds;
+            bool slower = compared && change > opts.threshold;
+            if ( compared )
+            {
+                baseline_seconds += base.seconds;
+                compared_seconds += r.seconds;
+            }
+            if ( wrong )
+                printf( r.answer == "CRASH" ? "  CRASHED" : "  WRONG ANSWER" );
+            else if ( slower )
+                printf( "  REGRESSION" );
+            regressions += wrong || slower;
+        }
+        else if ( r.answer == "WRONG" || r.answer == "CRASH" )
+        {
+            printf( r.answer == "CRASH" ? "  CRASHED" : "  WRONG ANSWER" );
+            ++regressions;
+        }
+        printf( "\n" );
+        fflush( stdout );
+    }
+
+    printf( "%-20s %-7s %9.3f %10zu %10.0f %12.0f %8.1f\n", "total", "", total.seconds
+          , total.conflicts, rate( total.conflicts, total.seconds )
+          , rate( total.propagations, total.seconds ), peak );
+
+    if ( opts.baseline && baseline_seconds > 0 )
+    {
+        double change = compared_seconds / baseline_seconds - 1;
+        printf( "compared instances %+.1f%% against the baseline", 100 * change );
+        if ( change > opts.threshold )
+        {
+            printf( ", REGRESSION" );
+            ++regressions;
+        }
+        printf( "\n" );
+    }
+
+    if ( opts.save )
+        save( opts.save, results );
+
+    return regressions > 0 ? 1 : 0;
+}
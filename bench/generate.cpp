@@ -0,0 +1,95 @@
+#include "generate.hpp"
+
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+
+cnf_t random_ksat( unsigned int var_count, size_t clause_count, unsigned int k
+                 , uint64_t seed )
+{
+    std::mt19937_64 random( seed );
+    std::uniform_int_distribution< var_t > variable( 1, var_count );
+
+    cnf_t cnf;
+    cnf.var_count = var_count;
+
+    clause_t c;
+    for ( size_t i = 0; i < clause_count; i++ )
+    {
+        c.clear();
+        while ( c.size() < k )
+        {
+            lit_t l = variable( random );
+            if ( std::find_if( c.begin(), c.end(), [&]( lit_t m ) {
+                     return var_of_lit( m ) == var_t( l ); } ) != c.end() )
+                continue;
+            c.push_back( random() & 1 ? l : -l );
+        }
+        cnf.add_clause( c );
+    }
+    return cnf;
+}
+
+
+cnf_t pigeonhole( unsigned int holes )
+{
+    unsigned int pigeons = holes + 1;
+    auto in = [&]( unsigned int pigeon, unsigned int hole ) {
+        return lit_t( pigeon * holes + hole + 1 );
+    };
+
+    cnf_t cnf;
+    cnf.var_count = pigeons * holes;
+
+    clause_t c;
+    for ( unsigned int p = 0; p < pigeons; p++ )
+    {
+        c.clear();
+        for ( unsigned int h = 0; h < holes; h++ )
+            c.push_back( in( p, h ) );
+        cnf.add_clause( c );
+    }
+
+    for ( unsigned int h = 0; h < holes; h++ )
+        for ( unsigned int p = 0; p < pigeons; p++ )
+            for ( unsigned int q = p + 1; q < pigeons; q++ )
+                cnf.add_clause( { -in( p, h ), -in( q, h ) } );
+    return cnf;
+}
+
+
+cnf_t parity( unsigned int var_count, bool satisfiable, uint64_t seed )
+{
+    std::mt19937_64 random( seed );
+
+    cnf_t cnf;
+    cnf.var_count = var_count;
+
+    // out = a xor b
+    auto add_xor = [&]( lit_t a, lit_t b ) {
+        lit_t out = ++cnf.var_count;
+        cnf.add_clause( { -out, a, b } );
+        cnf.add_clause( { -out, -a, -b } );
+        cnf.add_clause( { out, -a, b } );
+        cnf.add_clause( { out, a, -b } );
+        return out;
+    };
+
+    auto chain = [&]() {
+        std::vector< lit_t > order( var_count );
+        std::iota( order.begin(), order.end(), 1 );
+        std::shuffle( order.begin(), order.end(), random );
+
+        lit_t sum = order[ 0 ];
+        for ( unsigned int i = 1; i < var_count; i++ )
+            sum = add_xor( sum, order[ i ] );
+        return sum;
+    };
+
+    lit_t first = chain();
+    lit_t second = chain();
+    cnf.add_clause( { first } );
+    cnf.add_clause( { satisfiable ? second : -second } );
+    return cnf;
+}
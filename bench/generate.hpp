@@ -0,0 +1,20 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <cstdint>
+
+
+/** Uniform random k-SAT with var_count variables and clause_count clauses
+ *  of k distinct variables each, like the uf / uuf families of SATLIB. */
+cnf_t random_ksat( unsigned int var_count, size_t clause_count, unsigned int k
+                 , uint64_t seed );
+
+/** The pigeonhole principle for holes + 1 pigeons, always unsatisfiable. */
+cnf_t pigeonhole( unsigned int holes );
+
+/** The parity of var_count variables computed by two chains of XOR gates,
+ *  each summing them in a different random order. The results of the
+ *  chains are required to differ, which makes the formula unsatisfiable,
+ *  unless satisfiable is set. */
+cnf_t parity( unsigned int var_count, bool satisfiable, uint64_t seed );
@@ -0,0 +1,151 @@
+#include "heap.hpp"
+#include "timer.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+/** Microbenchmark of the variable heap under the access pattern of the
+ *  search: every conflict bumps a few dozen variables, most of them from
+ *  a slowly moving neighbourhood, and every restart takes some decisions
+ *  off the heap and puts them back. The bumps grow geometrically and are
+ *  rescaled as in the solver. */
+
+struct options_t
+{
+    size_t vars = 10000000;
+    size_t conflicts = 2000000;
+    size_t bumps = 32;
+    size_t decisions = 64;
+    double step = 1.01;
+};
+
+[[noreturn]] void usage()
+{
+    std::cerr << "usage: heap-bench [options]\n"
+                 "  --vars=N              variables in the heap ( default 10000000 )\n"
+                 "  --conflicts=N         conflicts simulated ( default 2000000 )\n"
+                 "  --bumps=N             variables bumped per conflict ( default 32 )\n"
+                 "  --decisions=N         variables extracted per conflict ( default 64 )\n"
+                 "  --step=X              growth of the bump per conflict ( default 1.01 )\n";
+    std::exit( 1 );
+}
+
+const char *option_value( const char *arg, const char *name )
+{
+    size_t length = std::strlen( name );
+    if ( std::strncmp( arg, name, length ) == 0 && arg[ length ] == '=' )
+        return arg + length + 1;
+    return nullptr;
+}
+
+options_t parse_options( int argc, char **argv )
+{
+    options_t opts;
+    for ( int i = 1; i < argc; i++ )
+    {
+        const char *arg = argv[ i ];
+        const char *value;
+
+        if ( ( value = option_value( arg, "--vars" ) ) )
+            opts.vars = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--conflicts" ) ) )
+            opts.conflicts = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--bumps" ) ) )
+            opts.bumps = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--decisions" ) ) )
+            opts.decisions = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--step" ) ) )
+            opts.step = std::atof( value );
+        else
+            usage();
+    }
+
+    if ( opts.vars == 0 || opts.step <= 1 )
+        usage();
+    return opts;
+}
+
+
+int main( int argc, char **argv )
+{
+    options_t opts = parse_options( argc, argv );
+    std::mt19937_64 random( 1 );
+
+    double build_seconds = 0, bump_seconds = 0, rescale_seconds = 0;
+    double extract_seconds = 0, drain_seconds = 0;
+    size_t bumps = 0, extracts = 0;
+    size_t rescales = 0;
+    uint64_t checksum = 0;
+
+    std::vector< var_t > taken;
+    std::vector< var_t > bumped( opts.bumps );
+    {
+        clock_type::time_point start = clock_type::now();
+        var_heap heap( opts.vars );
+        build_seconds = seconds_since( start );
+
+        double bump_size = 1.0;
+        std::uniform_int_distribution< var_t > spread( 0, 9999 );
+        std::uniform_int_distribution< var_t > any( 1, var_t( opts.vars ) );
+        var_t centre = 1;
+
+        for ( size_t c = 0; c < opts.conflicts; c++ )
+        {
+            // The neighbourhood drifts, and now and then a far variable.
+            if ( c % 1024 == 0 )
+                centre = any( random );
+            for ( var_t &v : bumped )
+                v = random() % 8 == 0 ? any( random )
+                                      : var_t( 1 + ( centre + spread( random ) ) % opts.vars );
+
+            {
+                scoped_timer b( &bump_seconds );
+                for ( var_t v : bumped )
+                    heap.bump( v, bump_size );
+            }
+            bump_size *= opts.step;
+            if ( bump_size > var_heap::max_score )
+            {
+                scoped_timer r( &rescale_seconds );
+                heap.rescale( bump_size );
+                bump_size = 1.0;
+                ++rescales;
+            }
+            bumps += bumped.size();
+
+            {
+                scoped_timer e( &extract_seconds );
+                taken.clear();
+                for ( size_t i = 0; i < opts.decisions && heap.size > 0; i++ )
+                    taken.push_back( heap.extract_max() );
+                for ( var_t v : taken )
+                    heap.push( v );
+            }
+            extracts += taken.size();
+            checksum += taken.empty() ? 0 : taken[ 0 ];
+        }
+
+        scoped_timer d( &drain_seconds );
+        while ( heap.size > 0 )
+            checksum += heap.extract_max();
+    }
+
+    auto rate = []( size_t count, double seconds ) {
+        return seconds > 0 ? count / seconds / 1e6 : 0.0;
+    };
+    printf( "variables        %zu\n", opts.vars );
+    printf( "build            %.3f s\n", build_seconds );
+    printf( "bump             %.3f s  %.2f M/s\n", bump_seconds, rate( bumps, bump_seconds ) );
+    printf( "rescale          %.3f s  %zu times\n", rescale_seconds, rescales );
+    printf( "extract + push   %.3f s  %.2f M/s\n", extract_seconds
+          , rate( extracts, extract_seconds ) );
+    printf( "drain            %.3f s  %.2f M/s\n", drain_seconds
+          , rate( opts.vars, drain_seconds ) );
+    printf( "checksum         %llu\n", (unsigned long long) checksum );
+    return 0;
+}
@@ -0,0 +1,300 @@
+#include "solver.hpp"
+#include "timer.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <vector>
+
+
+/** Microbenchmark of the clause memory layout under unit propagation with
+ *  two watched literals, on a random k-SAT formula. The search descends
+ *  from level 0 by random decisions until all variables are assigned or a
+ *  conflict, then starts over.
+ *
+ *  split is the layout before the clause arena: the first, second and
+ *  other literals of the clauses in three vectors, the sizes and offsets
+ *  in two more and 16 byte watchers. arena is clause_arena with 8 byte
+ *  watchers. Both visit the same watchers in the same order, the checksum
+ *  shows it. */
+
+struct options_t
+{
+    unsigned int vars = 1000000;
+    double ratio = 4.0;
+    unsigned int size = 3;
+    size_t descents = 10;
+};
+
+[[noreturn]] void usage()
+{
+    std::cerr << "usage: layout-bench [options]\n"
+                 "  --vars=N              variables of the formula ( default 1000000 )\n"
+                 "  --ratio=X             clauses per variable ( default 4 )\n"
+                 "  --size=N              literals per clause ( default 3 )\n"
+                 "  --descents=N          descents from level 0 ( default 10 )\n";
+    std::exit( 1 );
+}
+
+const char *option_value( const char *arg, const char *name )
+{
+    size_t length = std::strlen( name );
+    if ( std::strncmp( arg, name, length ) == 0 && arg[ length ] == '=' )
+        return arg + length + 1;
+    return nullptr;
+}
+
+options_t parse_options( int argc, char **argv )
+{
+    options_t opts;
+    for ( int i = 1; i < argc; i++ )
+    {
+        const char *arg = argv[ i ];
+        const char *value;
+
+        if ( ( value = option_value( arg, "--vars" ) ) )
+            opts.vars = std::strtoul( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--ratio" ) ) )
+            opts.ratio = std::atof( value );
+        else if ( ( value = option_value( arg, "--size" ) ) )
+            opts.size = std::strtoul( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--descents" ) ) )
+            opts.descents = std::strtoull( value, nullptr, 10 );
+        else
+            usage();
+    }
+
+    if ( opts.vars < 2 || opts.size < 3 || opts.size > opts.vars || opts.ratio <= 0 )
+        usage();
+    return opts;
+}
+
+
+struct split_layout
+{
+    struct watcher
+    {
+        idx_t clause;
+        lit_t blocker;
+    };
+
+    std::vector< lit_t > content_1;
+    std::vector< lit_t > content_2;
+    std::vector< lit_t > content_rest;
+    std::vector< size_t > beginnings;
+    std::vector< size_t > sizes;
+
+    idx_t add( const clause_t &c )
+    {
+        content_1.push_back( c[ 0 ] );
+        content_2.push_back( c[ 1 ] );
+        beginnings.push_back( content_rest.size() );
+        content_rest.insert( content_rest.end(), c.begin() + 2, c.end() );
+        sizes.push_back( c.size() );
+        return sizes.size() - 1;
+    }
+
+    size_t size( idx_t c ) const
+    {
+        return sizes[ c ];
+    }
+
+    lit_t &lit( idx_t c, size_t i )
+    {
+        if ( i == 0 )
+            return content_1[ c ];
+        if ( i == 1 )
+            return content_2[ c ];
+        return content_rest[ beginnings[ c ] + i - 2 ];
+    }
+};
+
+struct arena_layout
+{
+    struct watcher
+    {
+        cref_t clause;
+        lit_t blocker;
+    };
+
+    clause_arena clauses;
+
+    cref_t add( const clause_t &c )
+    {
+        return clauses.add( c );
+    }
+
+    size_t size( cref_t c ) const
+    {
+        return clauses.size( c );
+    }
+
+    lit_t &lit( cref_t c, size_t i )
+    {
+        return clauses.watched( c )[ i ];
+    }
+};
+
+
+struct counts
+{
+    double build_seconds = 0;
+    double search_seconds = 0;
+    size_t visits = 0;
+    size_t propagations = 0;
+    size_t conflicts = 0;
+    uint64_t checksum = 0;
+};
+
+template < typename layout >
+counts run( const std::vector< clause_t > &formula, const options_t &opts )
+{
+    using watcher = typename layout::watcher;
+
+    counts n;
+    layout clauses;
+    literal_map< std::vector< watcher > > watched_in( opts.vars );
+    {
+        scoped_timer t( &n.build_seconds );
+        for ( const clause_t &c : formula )
+        {
+            auto i_c = clauses.add( c );
+            watched_in[ c[ 0 ] ].push_back( { i_c, c[ 1 ] } );
+            watched_in[ c[ 1 ] ].push_back( { i_c, c[ 0 ] } );
+        }
+    }
+
+    std::vector< val_t > values( opts.vars + 1, val_un );
+    auto eval_lit = [&]( lit_t l ) {
+        val_t v = values[ var_of_lit( l ) ];
+        return l > 0 ? v : negate( v );
+    };
+
+    std::vector< lit_t > trail;
+    trail.reserve( opts.vars );
+    std::mt19937_64 random( 1 );
+
+    // The decisions follow a random order of the variables, from another
+    // start in each descent.
+    std::vector< var_t > order( opts.vars );
+    for ( var_t v = 1; v <= opts.vars; v++ )
+        order[ v - 1 ] = v;
+    std::shuffle( order.begin(), order.end(), random );
+
+    scoped_timer t( &n.search_seconds );
+    for ( size_t d = 0; d < opts.descents; d++ )
+    {
+        for ( lit_t l : trail )
+            values[ var_of_lit( l ) ] = val_un;
+        trail.clear();
+
+        size_t head = 0;
+        size_t next = random() % opts.vars;
+        bool conflict = false;
+        for ( size_t k = 0; k < opts.vars && ! conflict; k++ )
+        {
+            var_t v = order[ ( next + k ) % opts.vars ];
+            if ( values[ v ] != val_un )
+                continue;
+            lit_t decision = random() & 1 ? lit_t( v ) : - lit_t( v );
+            values[ v ] = val_of_lit( decision );
+            trail.push_back( decision );
+
+            while ( ! conflict && head < trail.size() )
+            {
+                lit_t l = trail[ head++ ];
+                auto &w_l = watched_in[ -l ];
+                idx_t i = 0, j = 0;
+                while ( i < w_l.size() )
+                {
+                    ++n.visits;
+                    if ( eval_lit( w_l[ i ].blocker ) == val_tt )
+                    {
+                        w_l[ j++ ] = w_l[ i++ ];
+                        continue;
+                    }
+
+                    auto i_c = w_l[ i++ ].clause;
+                    if ( clauses.lit( i_c, 0 ) == -l )
+                        std::swap( clauses.lit( i_c, 0 ), clauses.lit( i_c, 1 ) );
+
+                    watcher w = { i_c, clauses.lit( i_c, 0 ) };
+                    val_t v_0 = eval_lit( w.blocker );
+                    if ( v_0 == val_tt )
+                    {
+                        w_l[ j++ ] = w;
+                        continue;
+                    }
+
+                    bool found = false;
+                    for ( size_t i_l = 2; i_l < clauses.size( i_c ); i_l++ )
+                        if ( eval_lit( clauses.lit( i_c, i_l ) ) != val_ff )
+                        {
+                            std::swap( clauses.lit( i_c, i_l ), clauses.lit( i_c, 1 ) );
+                            watched_in[ clauses.lit( i_c, 1 ) ].push_back( w );
+                            found = true;
+                            break;
+                        }
+                    if ( found )
+                        continue;
+
+                    w_l[ j++ ] = w;
+                    if ( v_0 == val_ff )
+                    {
+                        ++n.conflicts;
+                        conflict = true;
+                        break;
+                    }
+                    ++n.propagations;
+                    values[ var_of_lit( w.blocker ) ] = val_of_lit( w.blocker );
+                    trail.push_back( w.blocker );
+                }
+                while ( i < w_l.size() )
+                    w_l[ j++ ] = w_l[ i++ ];
+                w_l.resize( j );
+            }
+        }
+        n.checksum = n.checksum * 31 + trail.size();
+    }
+    return n;
+}
+
+
+int main( int argc, char **argv )
+{
+    options_t opts = parse_options( argc, argv );
+
+    // Each clause has size distinct variables with random signs.
+    std::vector< clause_t > formula( size_t( opts.ratio * opts.vars ) );
+    std::mt19937_64 random( 1 );
+    std::uniform_int_distribution< var_t > any( 1, opts.vars );
+    for ( clause_t &c : formula )
+        while ( c.size() < opts.size )
+        {
+            var_t v = any( random );
+            bool fresh = true;
+            for ( lit_t l : c )
+                fresh &= var_of_lit( l ) != v;
+            if ( fresh )
+                c.push_back( random() & 1 ? lit_t( v ) : - lit_t( v ) );
+        }
+
+    counts split = run< split_layout >( formula, opts );
+    counts arena = run< arena_layout >( formula, opts );
+
+    auto rate = []( size_t count, double seconds ) {
+        return seconds > 0 ? count / seconds / 1e6 : 0.0;
+    };
+    printf( "%-8s %9s %9s %12s %10s %12s %10s\n", "layout", "build s", "search s"
+          , "visits", "visits/s", "propagations", "props/s" );
+    for ( auto [ name, n ] : { std::pair( "split", split ), std::pair( "arena", arena ) } )
+        printf( "%-8s %9.3f %9.3f %12zu %9.2fM %12zu %9.2fM\n", name, n.build_seconds
+              , n.search_seconds, n.visits, rate( n.visits, n.search_seconds )
+              , n.propagations, rate( n.propagations, n.search_seconds ) );
+    printf( "conflicts %zu, checksums %s\n", arena.conflicts
+          , split.checksum == arena.checksum ? "equal" : "DIFFERENT" );
+    return split.checksum == arena.checksum ? 0 : 1;
+}
@@ -22,10 +22,41 @@ inline const char* sat_to_str[] =
     "SAT", "UNSAT", "UNKNOWN"
 };
 
+/** Read-only view of a clause stored elsewhere. */
+struct clause_view
+{
+    const lit_t *first;
+    const lit_t *last;
+
+    const lit_t *begin() const { return first; }
+    const lit_t *end() const { return last; }
+    size_t size() const { return last - first; }
+    lit_t operator[]( size_t i ) const { return first[ i ]; }
+};
+
+/** The formula with all clauses in one flat vector, clause i consists of
+ *  literals[ offsets[ i ] ] up to literals[ offsets[ i + 1 ] ]. */
 struct cnf_t
 {
-    std::vector< clause_t > clauses; 
+    std::vector< lit_t > literals;
+    std::vector< size_t > offsets = { 0 };
     unsigned int var_count = 0;
+
+    size_t clause_count() const
+    {
+        return offsets.size() - 1;
+    }
+
+    clause_view clause( size_t i ) const
+    {
+        return { literals.data() + offsets[ i ], literals.data() + offsets[ i + 1 ] };
+    }
+
+    void add_clause( const clause_t &c )
+    {
+        literals.insert( literals.end(), c.begin(), c.end() );
+        offsets.push_back( literals.size() );
+    }
 };
 
 using val_t = char;
@@ -62,5 +93,21 @@ struct literal_map
     {
         return content[ l + var_count ];
     }
+
+    const T& operator[]( lit_t l ) const
+    {
+        return content[ l + var_count ];
+    }
+
+    /** Makes room for the literals of var_count variables, keeping the
+     *  values of the current ones. */
+    void resize( size_t new_count, T def = T() )
+    {
+        std::vector< T > moved( new_count * 2 + 1, def );
+        for ( lit_t l = - lit_t( var_count ); l <= lit_t( var_count ); l++ )
+            moved[ l + new_count ] = std::move( content[ l + var_count ] );
+        content.swap( moved );
+        var_count = new_count;
+    }
 };
 
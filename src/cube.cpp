@@ -0,0 +1,251 @@
+#include "cube.hpp"
+#include "portfolio.hpp"
+
+#include <thread>
+#include <cstdio>
+
+
+cube_and_conquer::cube_and_conquer( const cnf_t &cnf, unsigned int thread_count )
+    : cnf( cnf )
+    , thread_count( thread_count )
+    , initial_cubes( 4 * thread_count )
+    , solvers( thread_count )
+    , deques( new cube_deque[ thread_count ] )
+{}
+
+
+sat_t cube_and_conquer::solve()
+{
+    make_solver( 0 );
+    cube_initial();
+
+    if ( result == UNKNOWN )
+    {
+        std::vector< std::thread > threads;
+        for ( unsigned int i = 0; i < thread_count; i++ )
+            threads.emplace_back( [this, i]{ work( i ); } );
+
+        for ( auto &t : threads )
+            t.join();
+    }
+
+    return result;
+}
+
+
+void cube_and_conquer::print_stats()
+{
+    printf( "c initial cubes  %zu\n", stats.initial.load() );
+    printf( "c cubes solved   %zu\n", stats.solved.load() );
+    printf( "c cubes refuted  %zu\n", stats.refuted.load() );
+    printf( "c cube splits    %zu\n", stats.splits.load() );
+    printf( "c cube steals    %zu\n", stats.steals.load() );
+
+    size_t conflicts = 0;
+    for ( auto &s : solvers )
+        if ( s )
+            conflicts += s->stats.conflicts;
+    printf( "c total conflicts %zu\n", conflicts );
+}
+
+
+/** The workers get the diversification of the portfolio, the cubes make
+ *  them search different parts of the space anyway. */
+solver_config cube_and_conquer::config( unsigned int i )
+{
+    return portfolio::config( i, base );
+}
+
+
+void cube_and_conquer::make_solver( unsigned int i )
+{
+    solvers[ i ] = std::make_unique< solver >( cnf, config( i ) );
+    solvers[ i ]->stop = &stop;
+    if ( sharing )
+    {
+        solvers[ i ]->share = &ring;
+        solvers[ i ]->share_id = i;
+    }
+}
+
+
+/** Splits the formula by lookahead in breadth-first order until there
+ *  are initial_cubes cubes, and deals them out to the workers. */
+void cube_and_conquer::cube_initial()
+{
+    solver &s = *solvers[ 0 ];
+
+    std::deque< cube_t > open = { cube_t() };
+    std::vector< cube_t > done;
+
+    while ( ! open.empty() && open.size() + done.size() < initial_cubes )
+    {
+        cube_t c = std::move( open.front() );
+        open.pop_front();
+
+        bool refuted;
+        lit_t l = s.lookahead( c, candidates, refuted );
+        if ( refuted )
+            continue;
+        if ( l == 0 )
+        {
+            done.push_back( std::move( c ) );
+            continue;
+        }
+
+        ++stats.splits;
+        c.push_back( l );
+        open.push_back( c );
+        c.back() = -l;
+        open.push_back( std::move( c ) );
+    }
+
+    if ( s.inconsistent )
+    {
+        finish( 0, UNSAT );
+        return;
+    }
+
+    done.insert( done.end(), open.begin(), open.end() );
+    if ( done.empty() )
+    {
+        finish( 0, UNSAT );
+        return;
+    }
+
+    stats.initial = done.size();
+    pending = done.size();
+    for ( size_t i = 0; i < done.size(); i++ )
+        deques[ i % thread_count ].push( std::move( done[ i ] ) );
+}
+
+
+/** Takes a cube of worker i, or steals one from the others. */
+bool cube_and_conquer::take( unsigned int i, cube_t &c )
+{
+    if ( deques[ i ].pop( c ) )
+        return true;
+
+    for ( unsigned int k = 1; k < thread_count; k++ )
+    {
+        if ( deques[ ( i + k ) % thread_count ].steal( c ) )
+        {
+            ++stats.steals;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void cube_and_conquer::finish( unsigned int i, sat_t r )
+{
+    std::lock_guard< std::mutex > lock( mutex );
+    if ( winner < 0 )
+    {
+        winner = i;
+        result = r;
+        stop = true;
+    }
+    idle.notify_all();
+}
+
+
+/** Wakes the workers waiting for a cube, called after a split. Taking the
+ *  mutex orders the push before their next look at the deques. */
+void cube_and_conquer::wake_idle()
+{
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+    }
+    idle.notify_all();
+}
+
+
+void cube_and_conquer::wait_for_cube()
+{
+    auto any_cube = [&]{
+        for ( unsigned int k = 0; k < thread_count; k++ )
+            if ( ! deques[ k ].empty() )
+                return true;
+        return false;
+    };
+
+    std::unique_lock< std::mutex > lock( mutex );
+    idle.wait_for( lock, signal_poll, [&]{ return stop || pending == 0 || any_cube(); } );
+}
+
+
+void cube_and_conquer::work( unsigned int i )
+{
+    if ( ! solvers[ i ] )
+        make_solver( i );
+    solver &s = *solvers[ i ];
+
+    cube_t c;
+    while ( ! stop )
+    {
+        if ( ! take( i, c ) )
+        {
+            if ( pending == 0 )
+                break;
+            wait_for_cube();
+            continue;
+        }
+
+        sat_t r = s.solve( c, conflict_budget );
+
+        if ( r == SAT )
+        {
+            ++stats.solved;
+            finish( i, SAT );
+            break;
+        }
+
+        bool refuted = r == UNSAT;
+        if ( r == UNKNOWN )
+        {
+            if ( stop )
+                break;
+
+            // Out of the whole budget rather than that of the cube.
+            if ( s.limit_reached )
+            {
+                finish( i, UNKNOWN );
+                break;
+            }
+
+            lit_t l = s.lookahead( c, candidates, refuted );
+            if ( ! refuted )
+            {
+                // Without a variable to split on the cube is solved by
+                // propagation alone, the next try finds the model.
+                if ( l != 0 )
+                {
+                    ++stats.splits;
+                    ++pending;
+                    c.push_back( -l );
+                    deques[ i ].push( c );
+                    c.back() = l;
+                }
+                deques[ i ].push( std::move( c ) );
+                if ( l != 0 )
+                    wake_idle();
+                continue;
+            }
+        }
+
+        if ( s.inconsistent )
+        {
+            finish( i, UNSAT );
+            break;
+        }
+
+        ++stats.refuted;
+        if ( --pending == 0 )
+        {
+            finish( i, UNSAT );
+            break;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "base.hpp"
+#include "solver.hpp"
+#include "share.hpp"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+
+/** Assumptions which split the search space, the cubes of one split
+ *  cover it together. */
+using cube_t = std::vector< lit_t >;
+
+/** Cubes of one worker. The worker takes the newest cube from the back,
+ *  the others steal the oldest ( shortest, so hardest ) from the front. */
+struct cube_deque
+{
+    std::mutex mutex;
+    std::deque< cube_t > cubes;
+
+    void push( cube_t c )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        cubes.push_back( std::move( c ) );
+    }
+
+    bool pop( cube_t &c )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        if ( cubes.empty() )
+            return false;
+        c = std::move( cubes.back() );
+        cubes.pop_back();
+        return true;
+    }
+
+    bool empty()
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        return cubes.empty();
+    }
+
+    bool steal( cube_t &c )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        if ( cubes.empty() )
+            return false;
+        c = std::move( cubes.front() );
+        cubes.pop_front();
+        return true;
+    }
+};
+
+struct cube_stats
+{
+    std::atomic< size_t > initial { 0 };
+    std::atomic< size_t > solved { 0 };
+    std::atomic< size_t > refuted { 0 };
+    std::atomic< size_t > splits { 0 };
+    std::atomic< size_t > steals { 0 };
+};
+
+/** Cube-and-conquer. A lookahead cuber splits the formula into cubes which
+ *  are solved as assumptions by a pool of workers. A cube which is not
+ *  decided within the conflict budget is split again by lookahead and its
+ *  halves are pushed back. The search ends when a cube is satisfiable or
+ *  all of them are refuted. */
+struct cube_and_conquer
+{
+    const cnf_t &cnf;
+    unsigned int thread_count;
+
+    size_t conflict_budget = 2000;
+    size_t candidates = 32;
+    size_t initial_cubes;
+
+    std::vector< std::unique_ptr< solver > > solvers;
+    std::unique_ptr< cube_deque[] > deques;
+
+    clause_ring ring;
+    bool sharing = true;
+
+    solver_config base;
+
+    // Cubes which are neither refuted nor split.
+    std::atomic< size_t > pending { 0 };
+
+    std::atomic< bool > stop { false };
+    std::mutex mutex;
+    // Idle workers wait on it for a split or the end of the search. A stop
+    // by a signal cannot notify, they look at it every signal_poll.
+    std::condition_variable idle;
+    static constexpr std::chrono::milliseconds signal_poll { 50 };
+    int winner = -1;
+    sat_t result = UNKNOWN;
+
+    cube_stats stats;
+
+    cube_and_conquer( const cnf_t &cnf, unsigned int thread_count );
+
+    sat_t solve();
+
+    /** The solver which found the result, solver 0 when they were all
+     *  stopped. */
+    solver &best()
+    {
+        return *solvers[ winner >= 0 ? winner : 0 ];
+    }
+
+    void print_stats();
+
+    solver_config config( unsigned int i );
+
+    void make_solver( unsigned int i );
+
+    void cube_initial();
+
+    bool take( unsigned int i, cube_t &c );
+
+    void finish( unsigned int i, sat_t r );
+
+    void wake_idle();
+
+    void wait_for_cube();
+
+    void work( unsigned int i );
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <vector>
+#include <limits>
+#include <cassert>
+#include <algorithm>
+
+
+/** The activities of the variables and a max-heap of the variables by
+ *  them, for picking decisions.
+ *
+ *  The scores are floats in an array indexed by variable, the heap itself
+ *  only holds variables, so that moving one is a single 32-bit store, and
+ *  it is 4-ary, which halves the depth and keeps the children of a node
+ *  next to each other. The root is at position 0, the children of i are at
+ *  arity * i + 1 to arity * i + arity.
+ *
+ *  content holds all the variables: those at the positions below size are
+ *  in the heap, the rest were extracted and may be pushed back.
+ *
+ *  Dividing all the scores by the same factor keeps their order, so
+ *  rescale only walks the score array and leaves the heap as it is. */
+struct var_heap
+{
+    static constexpr size_t arity = 4;
+
+    // Bumps are rescaled before they get above this. A score is at most
+    // the bump times step / ( step - 1 ), for bumps growing by step, which
+    // stays well below the largest float for any sensible step.
+    static constexpr float max_score = 1e30f;
+
+    std::vector< float > score;
+
+    std::vector< var_t > content;
+
+    std::vector< var_t > var_idx;
+
+    size_t var_count;
+
+    size_t size;
+
+    static size_t parent( size_t i )
+    {
+        return ( i - 1 ) / arity;
+    }
+
+    static size_t first_child( size_t i )
+    {
+        return arity * i + 1;
+    }
+
+    var_heap( size_t var_count ) : var_count( var_count ), size( var_count )
+    {
+        score.resize( var_count + 1, 0.0f );
+        content.resize( var_count );
+        var_idx.resize( var_count + 1 );
+
+        for ( size_t i = 0; i < var_count; i++ )
+        {
+            var_idx[ i + 1 ] = i;
+            content[ i ] = i + 1;
+        }
+    }
+
+    /** Adds the variables up to new_count, at the bottom of the heap. */
+    void resize( size_t new_count )
+    {
+        score.resize( new_count + 1, 0.0f );
+        for ( var_t v = var_count + 1; v <= new_count; v++ )
+        {
+            var_idx.push_back( content.size() );
+            content.push_back( v );
+            push( v );
+        }
+        var_count = new_count;
+    }
+
+    bool contains( var_t var ) const
+    {
+        return var_idx[ var ] < size;
+    }
+
+    void push( var_t var )
+    {
+        if ( contains( var ) )
+            return;
+
+        place( content[ size ], var_idx[ var ] );
+        place( var, size );
+        ++ size;
+        move_up( size - 1 );
+    }
+
+    void set_priority( var_t var, float p )
+    {
+        score[ var ] = p;
+
+        if ( contains( var ) )
+        {
+            move_up( var_idx[ var ] );
+            move_down( var_idx[ var ] );
+        }
+    }
+
+    /** Raises the score of var, which can only move it up. */
+    void bump( var_t var, float amount )
+    {
+        score[ var ] += amount;
+
+        if ( contains( var ) )
+            move_up( var_idx[ var ] );
+    }
+
+    /** Divides all the scores by factor. Those which would become
+     *  denormal are flushed to zero, which keeps the order as well. */
+    void rescale( float factor )
+    {
+        const float tiny = std::numeric_limits< float >::min();
+        for ( var_t v = 1; v <= var_count; v++ )
+        {
+            float s = score[ v ] / factor;
+            score[ v ] = s < tiny ? 0.0f : s;
+        }
+    }
+
+    float priority( var_t var ) const
+    {
+        return score[ var ];
+    }
+
+    var_t top() const
+    {
+        assert( size != 0 );
+        return content[ 0 ];
+    }
+
+    var_t extract_max()
+    {
+        assert( size != 0 );
+
+        var_t var = content[ 0 ];
+        -- size;
+        place( content[ size ], 0 );
+        place( var, size );
+        if ( size > 0 )
+            move_down( 0 );
+
+        return var;
+    }
+
+    // The moves shift the variables on the way along and store the moved
+    // one only once, at its final position.
+
+    void move_up( size_t i )
+    {
+        var_t var = content[ i ];
+        float s = score[ var ];
+        while ( i != 0 )
+        {
+            size_t p = parent( i );
+            if ( score[ content[ p ] ] >= s )
+                break;
+
+            place( content[ p ], i );
+            i = p;
+        }
+        place( var, i );
+    }
+
+    void move_down( size_t i )
+    {
+        var_t var = content[ i ];
+        float s = score[ var ];
+        while ( first_child( i ) < size )
+        {
+            size_t first = first_child( i );
+            size_t last = std::min( first + arity, size );
+
+            size_t max_child = first;
+            float best = score[ content[ first ] ];
+            for ( size_t c = first + 1; c < last; c++ )
+                if ( score[ content[ c ] ] > best )
+                {
+                    max_child = c;
+                    best = score[ content[ c ] ];
+                }
+
+            if ( best <= s )
+                break;
+
+            place( content[ max_child ], i );
+            i = max_child;
+        }
+        place( var, i );
+    }
+
+    void place( var_t var, size_t i )
+    {
+        content[ i ] = var;
+        var_idx[ var ] = i;
+    }
+};
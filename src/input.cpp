@@ -0,0 +1,458 @@
+#include "input.hpp"
+
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_BZIP2
+#include <bzlib.h>
+#endif
+
+
+void input_error( const char *message )
+{
+    std::cerr << "c input error: " << message << std::endl;
+    std::exit( 1 );
+}
+
+
+/// Raw input /////////////////////////////////////////////////////////////////
+
+
+/** A regular file mapped into memory, the whole file is a single chunk. */
+struct mmap_input : input_t
+{
+    void *data = MAP_FAILED;
+
+    mmap_input( int fd, size_t size )
+    {
+        length = size;
+        if ( length == 0 )
+            return;
+
+        data = mmap( nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( data == MAP_FAILED )
+            input_error( "cannot map the input" );
+        madvise( data, length, MADV_SEQUENTIAL );
+
+        pos = static_cast< const char * >( data );
+        end = pos + length;
+    }
+
+    ~mmap_input()
+    {
+        if ( data != MAP_FAILED )
+            munmap( data, length );
+    }
+
+    bool refill() override
+    {
+        return false;
+    }
+};
+
+
+/** A pipe or terminal, read in large blocks. */
+struct block_input : input_t
+{
+    static constexpr size_t block_size = 1 << 20;
+
+    int fd;
+    std::vector< char > buffer;
+
+    block_input( int fd ) : fd( fd ), buffer( block_size ) {}
+
+    bool refill() override
+    {
+        ssize_t n;
+        do
+            n = read( fd, buffer.data(), buffer.size() );
+        while ( n < 0 && errno == EINTR );
+
+        if ( n < 0 )
+            input_error( "cannot read the input" );
+        if ( n == 0 )
+            return false;
+
+        pos = buffer.data();
+        end = pos + n;
+        return true;
+    }
+};
+
+
+/// Decoders //////////////////////////////////////////////////////////////////
+
+
+/** Decompresses the bytes of a raw input. */
+struct decoder_t
+{
+    const char *error = nullptr;
+
+    virtual ~decoder_t() = default;
+
+    /** Fills out with up to cap decompressed bytes. Returns their number,
+     *  0 at the end of the data and -1 on error. */
+    virtual long decode( input_t &raw, char *out, size_t cap ) = 0;
+};
+
+
+#ifdef HAVE_ZLIB
+struct gzip_decoder : decoder_t
+{
+    z_stream zs = {};
+
+    // Inside a member whose end has not been decoded yet.
+    bool in_member = false;
+
+    gzip_decoder()
+    {
+        // 32 lets zlib recognize the gzip header.
+        if ( inflateInit2( &zs, 15 + 32 ) != Z_OK )
+            input_error( "cannot initialize zlib" );
+    }
+
+    ~gzip_decoder()
+    {
+        inflateEnd( &zs );
+    }
+
+    /** At the end of the raw input, zlib is called without input until
+     *  the member ends, it fails with Z_BUF_ERROR if it is truncated. */
+    long decode( input_t &raw, char *out, size_t cap ) override
+    {
+        zs.next_out = reinterpret_cast< Bytef * >( out );
+        zs.avail_out = cap;
+
+        while ( zs.avail_out > 0 && ( in_member || raw.peek() != EOF ) )
+        {
+            bool at_end = raw.peek() == EOF;
+            zs.next_in = reinterpret_cast< Bytef * >( const_cast< char * >( raw.pos ) );
+            zs.avail_in = at_end ? 0 : raw.end - raw.pos;
+
+            int ret = inflate( &zs, Z_NO_FLUSH );
+            if ( ! at_end )
+                raw.pos = reinterpret_cast< const char * >( zs.next_in );
+
+            // Concatenated gzip members form a single file.
+            if ( ret == Z_STREAM_END )
+            {
+                inflateReset( &zs );
+                in_member = false;
+            }
+            else if ( ret == Z_BUF_ERROR && at_end )
+            {
+                error = "truncated gzip data";
+                return -1;
+            }
+            else if ( ret != Z_OK )
+            {
+                error = "corrupted gzip data";
+                return -1;
+            }
+            else
+                in_member = true;
+        }
+
+        return cap - zs.avail_out;
+    }
+};
+#endif
+
+
+#ifdef HAVE_LZMA
+struct xz_decoder : decoder_t
+{
+    lzma_stream xs = LZMA_STREAM_INIT;
+    bool finished = false;
+
+    xz_decoder()
+    {
+        if ( lzma_stream_decoder( &xs, UINT64_MAX, LZMA_CONCATENATED ) != LZMA_OK )
+            input_error( "cannot initialize liblzma" );
+    }
+
+    ~xz_decoder()
+    {
+        lzma_end( &xs );
+    }
+
+    long decode( input_t &raw, char *out, size_t cap ) override
+    {
+        xs.next_out = reinterpret_cast< uint8_t * >( out );
+        xs.avail_out = cap;
+
+        while ( xs.avail_out > 0 && ! finished )
+        {
+            lzma_action action = LZMA_RUN;
+            if ( raw.peek() == EOF )
+            {
+                action = LZMA_FINISH;
+                xs.avail_in = 0;
+            }
+            else
+            {
+                xs.next_in = reinterpret_cast< const uint8_t * >( raw.pos );
+                xs.avail_in = raw.end - raw.pos;
+            }
+
+            lzma_ret ret = lzma_code( &xs, action );
+            if ( action == LZMA_RUN )
+                raw.pos = reinterpret_cast< const char * >( xs.next_in );
+
+            if ( ret == LZMA_STREAM_END )
+                finished = true;
+            else if ( ret != LZMA_OK )
+            {
+                error = "corrupted xz data";
+                return -1;
+            }
+        }
+
+        return cap - xs.avail_out;
+    }
+};
+#endif
+
+
+#ifdef HAVE_BZIP2
+struct bzip2_decoder : decoder_t
+{
+    bz_stream bs = {};
+    bool open = false;
+
+    ~bzip2_decoder()
+    {
+        if ( open )
+            BZ2_bzDecompressEnd( &bs );
+    }
+
+    /** At the end of the raw input, an open stream is decoded without
+     *  input until it ends, it is truncated if that makes no progress. */
+    long decode( input_t &raw, char *out, size_t cap ) override
+    {
+        bs.next_out = out;
+        bs.avail_out = cap;
+
+        while ( bs.avail_out > 0 && ( open || raw.peek() != EOF ) )
+        {
+            // Concatenated streams form a single file.
+            if ( ! open )
+            {
+                if ( BZ2_bzDecompressInit( &bs, 0, 0 ) != BZ_OK )
+                    input_error( "cannot initialize libbz2" );
+                open = true;
+            }
+
+            bool at_end = raw.peek() == EOF;
+            unsigned int avail_out = bs.avail_out;
+            bs.next_in = const_cast< char * >( raw.pos );
+            bs.avail_in = at_end ? 0 : raw.end - raw.pos;
+
+            int ret = BZ2_bzDecompress( &bs );
+            if ( ! at_end )
+                raw.pos = bs.next_in;
+
+            if ( ret == BZ_STREAM_END )
+            {
+                BZ2_bzDecompressEnd( &bs );
+                open = false;
+            }
+            else if ( ret != BZ_OK )
+            {
+                error = "corrupted bzip2 data";
+                return -1;
+            }
+            else if ( at_end && bs.avail_out == avail_out )
+            {
+                error = "truncated bzip2 data";
+                return -1;
+            }
+        }
+
+        return cap - bs.avail_out;
+    }
+};
+#endif
+
+
+/// Decompressing input ///////////////////////////////////////////////////////
+
+
+/** Input decompressed by a worker thread. The worker fills one of two
+ *  buffers while the parser reads the other, so that the load time is
+ *  close to the slower of the two rather than their sum. */
+struct decompress_input : input_t
+{
+    static constexpr size_t buffer_size = 1 << 20;
+
+    std::unique_ptr< input_t > raw;
+    std::unique_ptr< decoder_t > decoder;
+
+    std::vector< char > buffers[ 2 ];
+    size_t filled[ 2 ] = { 0, 0 };
+    bool full[ 2 ] = { false, false };
+
+    // The buffer read by the parser and the one it reads next.
+    int current = -1;
+    int next = 0;
+
+    bool done = false;
+    bool stop = false;
+    const char *error = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread worker;
+
+    decompress_input( std::unique_ptr< input_t > raw_, std::unique_ptr< decoder_t > decoder_ )
+        : raw( std::move( raw_ ) )
+        , decoder( std::move( decoder_ ) )
+    {
+        buffers[ 0 ].resize( buffer_size );
+        buffers[ 1 ].resize( buffer_size );
+        worker = std::thread( [this]{ work(); } );
+    }
+
+    ~decompress_input()
+    {
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            stop = true;
+        }
+        changed.notify_all();
+        worker.join();
+    }
+
+    void work()
+    {
+        for ( int k = 0; ; k ^= 1 )
+        {
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                changed.wait( lock, [&]{ return ! full[ k ] || stop; } );
+                if ( stop )
+                    return;
+            }
+
+            long n = decoder->decode( *raw, buffers[ k ].data(), buffer_size );
+
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                if ( n <= 0 )
+                {
+                    error = decoder->error;
+                    done = true;
+                }
+                else
+                {
+                    filled[ k ] = n;
+                    full[ k ] = true;
+                }
+            }
+            changed.notify_all();
+
+            if ( n <= 0 )
+                return;
+        }
+    }
+
+    bool refill() override
+    {
+        std::unique_lock< std::mutex > lock( mutex );
+
+        if ( current >= 0 )
+        {
+            full[ current ] = false;
+            current = -1;
+            changed.notify_all();
+        }
+
+        changed.wait( lock, [&]{ return full[ next ] || done; } );
+        if ( ! full[ next ] )
+        {
+            if ( error != nullptr )
+                input_error( error );
+            return false;
+        }
+
+        current = next;
+        next ^= 1;
+        pos = buffers[ current ].data();
+        end = pos + filled[ current ];
+        return true;
+    }
+};
+
+
+/// Opening ///////////////////////////////////////////////////////////////////
+
+
+bool has_magic( input_t &in, const char *magic, size_t length )
+{
+    return size_t( in.end - in.pos ) >= length
+        && std::memcmp( in.pos, magic, length ) == 0;
+}
+
+
+std::unique_ptr< input_t > open_input( int fd )
+{
+    std::unique_ptr< input_t > raw;
+
+    struct stat st;
+    if ( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) )
+        raw = std::make_unique< mmap_input >( fd, st.st_size );
+    else
+        raw = std::make_unique< block_input >( fd );
+
+    // Look at the first chunk without consuming it.
+    raw->peek();
+
+    std::unique_ptr< decoder_t > decoder;
+
+    if ( has_magic( *raw, "\x1f\x8b", 2 ) )
+    {
+#ifdef HAVE_ZLIB
+        decoder = std::make_unique< gzip_decoder >();
+#else
+        input_error( "built without gzip support" );
+#endif
+    }
+    else if ( has_magic( *raw, "\xfd" "7zXZ\x00", 6 ) )
+    {
+#ifdef HAVE_LZMA
+        decoder = std::make_unique< xz_decoder >();
+#else
+        input_error( "built without xz support" );
+#endif
+    }
+    else if ( has_magic( *raw, "BZh", 3 ) )
+    {
+#ifdef HAVE_BZIP2
+        decoder = std::make_unique< bzip2_decoder >();
+#else
+        input_error( "built without bzip2 support" );
+#endif
+    }
+
+    if ( ! decoder )
+        return raw;
+
+    return std::make_unique< decompress_input >( std::move( raw ), std::move( decoder ) );
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <memory>
+
+
+/** Source of the input bytes in chunks. The parser reads the current chunk
+ *  [ pos, end ) and asks for the next one when it runs out. */
+struct input_t
+{
+    const char *pos = nullptr;
+    const char *end = nullptr;
+
+    /** Length of the whole input in bytes, 0 when it is not known before
+     *  reading it, e.g. for pipes and compressed input. */
+    size_t length = 0;
+
+    virtual ~input_t() = default;
+
+    /** Makes the next chunk current, returns false at the end of input. */
+    virtual bool refill() = 0;
+
+    int peek()
+    {
+        if ( pos == end && ! refill() )
+            return EOF;
+        return static_cast< unsigned char >( *pos );
+    }
+
+    void skip()
+    {
+        ++pos;
+    }
+};
+
+
+[[noreturn]] void input_error( const char *message );
+
+/** Opens the input on the file descriptor fd. Regular files are mapped
+ *  into memory, anything else is read in blocks. Input compressed by gzip,
+ *  xz or bzip2 is recognized by its magic bytes and decompressed on a
+ *  separate thread. */
+std::unique_ptr< input_t > open_input( int fd );
@@ -1,27 +1,227 @@
-#include <iostream> 
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
 #include "parser.hpp"
 #include "solver.hpp"
+#include "portfolio.hpp"
+#include "cube.hpp"
+#include "proof.hpp"
+#include "simplify.hpp"
+#include "sls.hpp"
+#include "timer.hpp"
 
-void sat_solve( cnf_t cnf )
+enum solve_mode_t
 {
-    solver s( std::move( cnf ) );
-    sat_t res = s.solve();
+    CDCL, CUBE, SLS
+};
+
+struct options_t
+{
+    solve_mode_t mode = CDCL;
+    const char *input = nullptr;
+    const char *proof = nullptr;
+    proof_t proof_format = BINARY_DRAT;
+    unsigned int threads = 1;
+    unsigned int share_lbd = 3;
+    size_t cube_budget = 2000;
+    double simplify = 10.0;
+    double inprocess = 0.1;
+    restart_t restarts = LUBY;
+    decide_t heuristic = VSIDS;
+    unsigned int target = 1;
+    size_t rephase = 1000;
+    double walk = 0.1;
+    size_t chrono = 100;
+    double report = 10.0;
+    bool profile = false;
+    const char *stats_json = nullptr;
+    const char *simplify_out = nullptr;
+    solver_limits limits;
+};
+
+[[noreturn]] void usage()
+{
+    std::cerr << "usage: sat [options] [input.cnf]\n"
+                 "  --mode=MODE           cdcl ( default ), cube ( cube-and-conquer ) or\n"
+                 "                        sls ( local search, finds models only )\n"
+                 "  --proof=FILE          write a proof of unsatisfiability to FILE\n"
+                 "  --proof-format=FMT    binary ( binary DRAT, default ), drat or lrat\n"
+                 "  --threads=N           run a portfolio of N diversified solvers\n"
+                 "  --share-lbd=N         share learnt clauses up to lbd N between\n"
+                 "                        the threads ( default 3, 0 disables )\n"
+                 "  --cube-budget=N       conflicts spent on a cube before it is split\n"
+                 "                        ( default 2000 )\n"
+                 "  --simplify=SECONDS    time limit of the preprocessing ( default 10,\n"
+                 "                        0 disables it, as do LRAT proofs )\n"
+                 "  --simplify-out=FILE   write the simplified formula to FILE and exit\n"
+                 "  --inprocess=EFFORT    fraction of the search spent on inprocessing\n"
+                 "                        ( default 0.1, 0 disables it )\n"
+                 "  --restarts=POLICY     luby ( default ), geometric, glucose ( restarts\n"
+                 "                        on lbd averages ) or switching ( between\n"
+                 "                        glucose and luby )\n"
+                 "  --decide=HEURISTIC    vsids ( default ), vmtf ( move to front ) or\n"
+                 "                        mixed ( vmtf in focused mode, vsids in stable )\n"
+                 "  --target=N            decide the target phases 0 never, 1 in stable\n"
+                 "                        mode ( default ), 2 always\n"
+                 "  --rephase=N           reset the phases after N, 2N, ... conflicts\n"
+                 "                        ( default 1000, 0 disables it )\n"
+                 "  --walk=EFFORT         fraction of the search spent on local search\n"
+                 "                        seeding the phases ( default 0.1, 0 disables it )\n"
+                 "  --chrono=N            backtrack one level instead of backjumping over\n"
+                 "                        more than N levels ( default 100, 0 never )\n"
+                 "  --report=SECONDS      print a progress line every SECONDS ( default\n"
+                 "                        10, 0 disables it )\n"
+                 "  --profile             measure the time spent in the parts of the\n"
+                 "                        search\n"
+                 "  --stats-json=FILE     write the statistics to FILE as JSON\n"
+                 "  --max-conflicts=N     give up with s UNKNOWN after N conflicts\n"
+                 "  --max-propagations=N  give up after N propagations\n"
+                 "  --time-limit=SECONDS  give up after SECONDS of wall-clock time\n"
+                 "  --memory-limit=MB     give up when the memory used exceeds MB\n";
+    std::exit( 1 );
+}
+
+const char *option_value( const char *arg, const char *name )
+{
+    size_t length = std::strlen( name );
+    if ( std::strncmp( arg, name, length ) == 0 && arg[ length ] == '=' )
+        return arg + length + 1;
+    return nullptr;
+}
+
+options_t parse_options( int argc, char **argv )
+{
+    options_t opts;
+    for ( int i = 1; i < argc; i++ )
+    {
+        const char *arg = argv[ i ];
+        const char *value;
+
+        if ( ( value = option_value( arg, "--mode" ) ) )
+        {
+            if ( std::strcmp( value, "cdcl" ) == 0 )
+                opts.mode = CDCL;
+            else if ( std::strcmp( value, "cube" ) == 0 )
+                opts.mode = CUBE;
+            else if ( std::strcmp( value, "sls" ) == 0 )
+                opts.mode = SLS;
+            else
+                usage();
+        }
+        else if ( ( value = option_value( arg, "--proof" ) ) )
+            opts.proof = value;
+        else if ( ( value = option_value( arg, "--proof-format" ) ) )
+        {
+            if ( std::strcmp( value, "binary" ) == 0 )
+                opts.proof_format = BINARY_DRAT;
+            else if ( std::strcmp( value, "drat" ) == 0 )
+                opts.proof_format = DRAT;
+            else if ( std::strcmp( value, "lrat" ) == 0 )
+                opts.proof_format = LRAT;
+            else
+                usage();
+        }
+        else if ( ( value = option_value( arg, "--threads" ) ) )
+        {
+            int threads = std::atoi( value );
+            if ( threads < 1 )
+                usage();
+            opts.threads = threads;
+        }
+        else if ( ( value = option_value( arg, "--share-lbd" ) ) )
+            opts.share_lbd = std::atoi( value );
+        else if ( ( value = option_value( arg, "--cube-budget" ) ) )
+            opts.cube_budget = std::max( 1, std::atoi( value ) );
+        else if ( ( value = option_value( arg, "--simplify" ) ) )
+            opts.simplify = std::max( 0.0, std::atof( value ) );
+        else if ( ( value = option_value( arg, "--simplify-out" ) ) )
+            opts.simplify_out = value;
+        else if ( ( value = option_value( arg, "--inprocess" ) ) )
+            opts.inprocess = std::max( 0.0, std::atof( value ) );
+        else if ( ( value = option_value( arg, "--restarts" ) ) )
+        {
+            if ( std::strcmp( value, "luby" ) == 0 )
+                opts.restarts = LUBY;
+            else if ( std::strcmp( value, "geometric" ) == 0 )
+                opts.restarts = GEOMETRIC;
+            else if ( std::strcmp( value, "glucose" ) == 0 )
+                opts.restarts = GLUCOSE;
+            else if ( std::strcmp( value, "switching" ) == 0 )
+                opts.restarts = SWITCHING;
+            else
+                usage();
+        }
+        else if ( ( value = option_value( arg, "--decide" ) ) )
+        {
+            if ( std::strcmp( value, "vsids" ) == 0 )
+                opts.heuristic = VSIDS;
+            else if ( std::strcmp( value, "vmtf" ) == 0 )
+                opts.heuristic = VMTF;
+            else if ( std::strcmp( value, "mixed" ) == 0 )
+                opts.heuristic = MIXED;
+            else
+                usage();
+        }
+        else if ( ( value = option_value( arg, "--target" ) ) )
+            opts.target = std::min( 2, std::max( 0, std::atoi( value ) ) );
+        else if ( ( value = option_value( arg, "--rephase" ) ) )
+            opts.rephase = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--walk" ) ) )
+            opts.walk = std::max( 0.0, std::atof( value ) );
+        else if ( ( value = option_value( arg, "--chrono" ) ) )
+            opts.chrono = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--report" ) ) )
+            opts.report = std::max( 0.0, std::atof( value ) );
+        else if ( std::strcmp( arg, "--profile" ) == 0 )
+            opts.profile = true;
+        else if ( ( value = option_value( arg, "--stats-json" ) ) )
+            opts.stats_json = value;
+        else if ( ( value = option_value( arg, "--max-conflicts" ) ) )
+            opts.limits.conflicts = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--max-propagations" ) ) )
+            opts.limits.propagations = std::strtoull( value, nullptr, 10 );
+        else if ( ( value = option_value( arg, "--time-limit" ) ) )
+            opts.limits.seconds = std::max( 0.0, std::atof( value ) );
+        else if ( ( value = option_value( arg, "--memory-limit" ) ) )
+            opts.limits.memory_mb = std::strtoull( value, nullptr, 10 );
+        else if ( arg[ 0 ] == '-' && arg[ 1 ] != 0 )
+            usage();
+        else if ( opts.input == nullptr )
+            opts.input = arg;
+        else
+            usage();
+    }
 
+    if ( opts.proof != nullptr && ( opts.threads > 1 || opts.mode != CDCL ) )
+    {
+        std::cerr << "c a proof can only be written by a single thread" << std::endl;
+        std::exit( 1 );
+    }
+    return opts;
+}
+
+void print_answer( sat_t res, const std::vector< val_t > &values )
+{
     if ( res == UNSAT )
     {
         std::cout << "s UNSATISFIABLE" << std::endl;
         return;
     }
 
-    if ( res == SAT ) 
+    if ( res == SAT )
     {
         std::cout << "s SATISFIABLE" << std::endl;
 
         // print model
         std::cout << "v ";
-        for ( sidx_t v = 1; v <= s.var_count; v++ )
+        for ( sidx_t v = 1; v < sidx_t( values.size() ); v++ )
         {
-            std::cout << (s.values[ v ] == val_tt ? v : -v) << " ";
+            std::cout << (values[ v ] == val_tt ? v : -v) << " ";
         }
         std::cout << "0\n";
 
@@ -35,14 +235,200 @@ void sat_solve( cnf_t cnf )
     }
 }
 
-int main()
+const clock_type::time_point program_start = clock_type::now();
+
+// Set by SIGINT and SIGTERM, as is the stop flag of the portfolio or the
+// cube-and-conquer which is running, if any. A second signal kills.
+std::atomic< bool > interrupted { false };
+std::atomic< std::atomic< bool > * > search_stop { nullptr };
+
+extern "C" void on_signal( int signal )
+{
+    interrupted = true;
+    if ( std::atomic< bool > *stop = search_stop.load() )
+        *stop = true;
+    std::signal( signal, SIG_DFL );
+}
+
+/** Stops the parallel search by stop on a signal, including one which
+ *  came before. */
+void stop_on_signal( std::atomic< bool > &stop )
+{
+    search_stop = &stop;
+    if ( interrupted )
+        stop = true;
+}
+
+
+void print_result( solver &s, sat_t res )
+{
+    s.print_stats();
+    print_answer( res, s.values );
+}
+
+/** Writes the result, the time of the preprocessing and the statistics of
+ *  the solver or local search s which found the result to
+ *  opts.stats_json. */
+template< typename engine_t >
+void write_stats( const options_t &opts, engine_t &s, sat_t res
+                , double parse_seconds, const simplifier *simp )
+{
+    std::ofstream out( opts.stats_json );
+    out << "{\n"
+        << "    \"result\": \"" << sat_to_str[ res ] << "\",\n"
+        << "    \"parse_seconds\": " << parse_seconds << ",\n";
+    if ( simp )
+        out << "    \"simplify_seconds\": " << simp->stats.seconds << ",\n";
+    out << "    \"solver\": ";
+    s.write_json( out, 8 );
+    out << "\n}\n";
+
+    if ( ! out )
+    {
+        std::cerr << "c cannot write " << opts.stats_json << std::endl;
+        std::exit( 1 );
+    }
+}
+
+void sat_solve( cnf_t cnf, const options_t &opts, double parse_seconds )
+{
+    std::unique_ptr< proof_writer > proof;
+    if ( opts.proof != nullptr )
+        proof = std::make_unique< proof_writer >( opts.proof, opts.proof_format );
+
+    // The simplified formula replaces the original one, a model of it is
+    // extended to the eliminated variables before it is printed.
+    std::unique_ptr< simplifier > simp;
+    if ( opts.simplify > 0 && ! ( proof && proof->lrat() ) )
+    {
+        simplify_config config;
+        config.max_seconds = opts.simplify;
+        if ( opts.limits.seconds > 0 )
+            config.max_seconds = std::min( config.max_seconds, opts.limits.seconds / 2 );
+        simp = std::make_unique< simplifier >( cnf, config, proof.get() );
+        simp->stop = &interrupted;
+        simp->simplify();
+        simp->print_stats();
+        cnf = simp->formula();
+    }
+
+    if ( opts.simplify_out != nullptr )
+    {
+        std::ofstream out( opts.simplify_out );
+        show_dimacs( cnf, out );
+        if ( ! out )
+        {
+            std::cerr << "c cannot write " << opts.simplify_out << std::endl;
+            std::exit( 1 );
+        }
+        return;
+    }
+
+    solver_config config;
+    config.inprocess = opts.inprocess > 0;
+    config.inprocess_effort = opts.inprocess;
+    config.restarts = opts.restarts;
+    config.heuristic = opts.heuristic;
+    config.target_phases = opts.target;
+    config.rephase_interval = opts.rephase;
+    config.walk_effort = opts.walk;
+    config.chrono_levels = opts.chrono;
+    config.profile = opts.profile;
+    config.report_interval = opts.report;
+
+    // The time limit is for the whole run, the solvers start counting now.
+    config.limits = opts.limits;
+    if ( opts.limits.seconds > 0 )
+        config.limits.seconds = std::max( 1e-3, opts.limits.seconds - seconds_since( program_start ) );
+
+    auto finish = [&]( solver &s, sat_t res ) {
+        if ( res == SAT && simp )
+            simp->extend( s.values );
+        if ( res == UNKNOWN )
+            std::cout << ( interrupted ? "c interrupted" : "c resource limit reached" ) << std::endl;
+        print_result( s, res );
+        if ( opts.stats_json != nullptr )
+            write_stats( opts, s, res, parse_seconds, simp.get() );
+    };
+
+    if ( opts.mode == SLS )
+    {
+        sls_config sc;
+        sc.max_seconds = config.limits.seconds;
+        local_search ls( cnf, sc );
+        ls.stop = &interrupted;
+        ls.assign_random();
+        sat_t res = ls.walk();
+
+        std::vector< val_t > model = ls.best_values();
+        if ( res == SAT && simp )
+            simp->extend( model );
+        if ( res == UNKNOWN )
+            std::cout << ( interrupted ? "c interrupted" : "c resource limit reached" ) << std::endl;
+        ls.print_stats();
+        print_answer( res, model );
+        if ( opts.stats_json != nullptr )
+            write_stats( opts, ls, res, parse_seconds, simp.get() );
+        return;
+    }
+
+    if ( opts.mode == CUBE )
+    {
+        cube_and_conquer cc( cnf, opts.threads );
+        cc.sharing = opts.share_lbd > 0 && opts.threads > 1;
+        cc.ring.max_lbd = opts.share_lbd;
+        cc.conflict_budget = opts.cube_budget;
+        cc.base = config;
+        stop_on_signal( cc.stop );
+        sat_t res = cc.solve();
+        cc.print_stats();
+        finish( cc.best(), res );
+        return;
+    }
+
+    if ( opts.threads > 1 )
+    {
+        portfolio p( cnf, opts.threads );
+        p.sharing = opts.share_lbd > 0;
+        p.ring.max_lbd = opts.share_lbd;
+        p.base = config;
+        stop_on_signal( p.stop );
+        sat_t res = p.solve();
+        std::cout << "c solved by thread " << p.winner << std::endl;
+        finish( p.best(), res );
+        return;
+    }
+
+    solver s( cnf, config, proof.get() );
+    s.stop = &interrupted;
+
+    // The solver has copied the clauses, the formula is not needed any more.
+    cnf = cnf_t {};
+    sat_t res = s.solve();
+
+    // The proof is complete before the answer is announced.
+    proof.reset();
+
+    finish( s, res );
+}
+
+int main( int argc, char **argv )
 {
-    cnf_t cnf = parse_dimacs();
+    options_t opts = parse_options( argc, argv );
+    std::signal( SIGINT, on_signal );
+    std::signal( SIGTERM, on_signal );
+
+    cnf_t cnf;
+    double parse_seconds = 0;
+    {
+        scoped_timer t( &parse_seconds );
+        cnf = parse_dimacs( opts.input );
+    }
+    printf( "c parse time     %.2f s\n", parse_seconds );
 
     // std::cout << "PROBLEM" << std::endl;
     // show_dimacs( cnf );
 
     // std::cout << "SOLUTION" << std::endl;
-    sat_solve( std::move( cnf ) );
+    sat_solve( std::move( cnf ), opts, parse_seconds );
 }
-
@@ -1,55 +1,226 @@
-#include "parser.hpp" 
+#include "parser.hpp"
+#include "input.hpp"
 
 #include <vector>
 #include <string>
 #include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#include <new>
 
-clause_t parse_clause( unsigned int i, literal_map< unsigned int > &seen )
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/// Errors ////////////////////////////////////////////////////////////////////
+
+
+[[noreturn]] void parse_error( const char *message )
+{
+    std::cerr << "c parse error: " << message << std::endl;
+    std::exit( 1 );
+}
+
+
+/// Tokenizer /////////////////////////////////////////////////////////////////
+
+
+bool is_space( int c )
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+
+void skip_line( input_t &in )
+{
+    int c;
+    while ( ( c = in.peek() ) != EOF && c != '\n' )
+        in.skip();
+}
+
+
+void skip_space( input_t &in )
+{
+    while ( is_space( in.peek() ) )
+        in.skip();
+}
+
+
+/** Skips white space and comment lines, returns the next character. */
+int skip_blank( input_t &in )
 {
-    clause_t clause;
-    int read = -1; 
-    std::cin >> read;
+    while ( true )
+    {
+        int c = in.peek();
+        if ( is_space( c ) )
+            in.skip();
+        else if ( c == 'c' )
+            skip_line( in );
+        else
+            return c;
+    }
+}
+
+
+long long scan_int( input_t &in )
+{
+    int c = skip_blank( in );
+
+    bool negative = c == '-';
+    if ( c == '-' || c == '+' )
+    {
+        in.skip();
+        c = in.peek();
+    }
+
+    if ( c < '0' || c > '9' )
+        parse_error( "expected a number" );
+
+    long long value = 0;
+    while ( c >= '0' && c <= '9' )
+    {
+        value = value * 10 + ( c - '0' );
+        if ( value > INT_MAX )
+            parse_error( "number out of range" );
+        in.skip();
+        c = in.peek();
+    }
+
+    return negative ? -value : value;
+}
+
+
+void scan_word( input_t &in, const char *word )
+{
+    skip_space( in );
+    for ( const char *w = word; *w != 0; w++ )
+    {
+        if ( in.peek() != *w )
+            parse_error( "malformed problem line" );
+        in.skip();
+    }
+}
+
+
+/// Parser ////////////////////////////////////////////////////////////////////
+
+
+/** Appends the next clause to the flat storage of cnf, dropping duplicate
+ *  literals. Short clauses are checked for duplicates by a linear scan,
+ *  which unlike the seen map does not miss the cache. Clause i marks its
+ *  literals in seen with i. */
+void parse_clause( input_t &in, cnf_t &cnf, unsigned int i, literal_map< unsigned int > &seen )
+{
+    const size_t scan_limit = 16;
+
+    size_t begin = cnf.literals.size();
+    long long read = scan_int( in );
     while ( read != 0 ) {
-        if ( seen[ read ] != i ) {
-            clause.push_back( read );
-            seen[ read ] = i;
+        if ( read > cnf.var_count || -read > cnf.var_count )
+            parse_error( "literal out of range" );
+
+        lit_t l = static_cast< lit_t >( read );
+        size_t size = cnf.literals.size() - begin;
+
+        if ( size < scan_limit )
+        {
+            bool duplicate = false;
+            for ( size_t j = begin; j < cnf.literals.size(); j++ )
+                duplicate |= cnf.literals[ j ] == l;
+            if ( ! duplicate )
+                cnf.literals.push_back( l );
         }
-        std::cin >> read;
+        else
+        {
+            if ( size == scan_limit )
+                for ( size_t j = begin; j < cnf.literals.size(); j++ )
+                    seen[ cnf.literals[ j ] ] = i;
+
+            if ( seen[ l ] != i ) {
+                cnf.literals.push_back( l );
+                seen[ l ] = i;
+            }
+        }
+        read = scan_int( in );
     }
-    return clause;
+    cnf.offsets.push_back( cnf.literals.size() );
 }
 
 
-cnf_t parse_dimacs()
+cnf_t parse_dimacs( input_t &in )
 {
-    std::string s;
+    if ( skip_blank( in ) != 'p' )
+        parse_error( "missing problem line" );
+    in.skip();
+    scan_word( in, "cnf" );
+
+    long long var_count = scan_int( in );
+    long long clause_count = scan_int( in );
+    if ( var_count < 0 || clause_count < 0 )
+        parse_error( "negative size in the problem line" );
+
+    // The sizes in the header are not trusted for memory: a clause takes
+    // at least 2 bytes of the input, "0\n", and so does a literal. Where
+    // the length is not known the storage grows as the clauses are read.
+    size_t clause_bound = std::min< size_t >( clause_count, in.length / 2 );
+    size_t literal_bound = std::min< size_t >( clause_count * 3, in.length / 2 );
 
-    std::cin >> s;
+    cnf_t cnf;
+    try
+    {
+        literal_map< unsigned int > seen( var_count, 0 );
+
+        cnf.var_count = var_count;
+        cnf.offsets.reserve( clause_bound + 1 );
+        cnf.literals.reserve( literal_bound );
 
-    while ( s == "c" ) 
+        // Whatever follows the announced clauses is ignored, e.g. the '%' at
+        // the end of the SATLIB instances, but a truncated input is an error.
+        for ( long long i = 0; i < clause_count; i++ )
+        {
+            if ( skip_blank( in ) == EOF )
+                parse_error( "fewer clauses than announced" );
+            parse_clause( in, cnf, i + 1, seen );
+        }
+    }
+    catch ( const std::bad_alloc & )
     {
-        std::getline( std::cin, s );
-        std::cin >> s;
+        parse_error( "not enough memory for the formula" );
     }
 
-    unsigned int var_count, clause_count;
-    std::cin >> s >> var_count >> clause_count;
+    return cnf;
+}
+
+
+cnf_t parse_dimacs( const char *path )
+{
+    int fd = 0;
+    if ( path != nullptr )
+    {
+        fd = open( path, O_RDONLY );
+        if ( fd < 0 )
+            parse_error( "cannot open the input file" );
+    }
 
-    literal_map< unsigned int > seen( var_count, 0 );
+    auto in = open_input( fd );
+    cnf_t cnf = parse_dimacs( *in );
 
-    cnf_t cnf{ {}, var_count };
-    for( unsigned int i = 0; i < clause_count; i++ )
-        cnf.clauses.push_back( parse_clause( i + 1, seen ) );
+    in.reset();
+    if ( path != nullptr )
+        close( fd );
     return cnf;
 }
 
-void show_dimacs( const cnf_t &cnf )
+
+void show_dimacs( const cnf_t &cnf, std::ostream &out )
 {
-    std::cout << "p cnf " << cnf.clauses.size() << " " << cnf.var_count << std::endl;
-    for ( auto &c : cnf.clauses )
+    out << "p cnf " << cnf.var_count << " " << cnf.clause_count() << "\n";
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
     {
-        for ( auto l : c )
-            std::cout << l << " ";
-        std::cout << std::endl;
+        for ( auto l : cnf.clause( i ) )
+            out << l << " ";
+        out << "0\n";
     }
+    out.flush();
 }
@@ -2,6 +2,10 @@
 
 #include "base.hpp"
 
-cnf_t parse_dimacs();
+#include <iostream>
 
-void show_dimacs( const cnf_t &cnf );
+/** Reads a DIMACS CNF from the file at path, or from the standard input
+ *  when path is null. */
+cnf_t parse_dimacs( const char *path = nullptr );
+
+void show_dimacs( const cnf_t &cnf, std::ostream &out = std::cout );
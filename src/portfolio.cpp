@@ -0,0 +1,76 @@
+#include "portfolio.hpp"
+
+#include <thread>
+
+
+portfolio::portfolio( const cnf_t &cnf, unsigned int thread_count )
+    : cnf( cnf )
+    , thread_count( thread_count )
+    , binaries( cnf )
+    , solvers( thread_count )
+{}
+
+
+sat_t portfolio::solve()
+{
+    std::vector< std::thread > threads;
+    for ( unsigned int i = 0; i < thread_count; i++ )
+        threads.emplace_back( [this, i]{ run( i ); } );
+
+    for ( auto &t : threads )
+        t.join();
+
+    return result;
+}
+
+
+/** Solver 0 runs with the base configuration c, the others cycle through
+ *  the initial phases and the restart and decay parameters, with a
+ *  different random variable order each. The odd ones switch between
+ *  focused and stable restarts, the Luby base applies to the latter. */
+solver_config portfolio::config( unsigned int i, solver_config c )
+{
+    static const val_t phases[] = { val_tt, val_ff, val_un };
+    static const unsigned int luby_bases[] = { 420, 100, 256, 50, 1000 };
+    static const double bump_steps[] = { 1.01, 1.05, 1.02, 1.08 };
+
+    c.share_formula = true;
+    if ( i == 0 )
+        return c;
+
+    // Only solver 0 prints the progress.
+    c.report_interval = 0;
+    c.seed = i;
+    c.phase = phases[ i % 3 ];
+    c.luby_base = luby_bases[ i % 5 ];
+    if ( i % 2 == 1 )
+        c.restarts = SWITCHING;
+    c.bump_step = bump_steps[ i % 4 ];
+    return c;
+}
+
+
+void portfolio::run( unsigned int i )
+{
+    solver_config c = config( i, base );
+    c.formula_binaries = &binaries;
+    solvers[ i ] = std::make_unique< solver >( cnf, c );
+    solvers[ i ]->stop = &stop;
+    if ( sharing )
+    {
+        solvers[ i ]->share = &ring;
+        solvers[ i ]->share_id = i;
+    }
+
+    sat_t r = solvers[ i ]->solve();
+    if ( r == UNKNOWN )
+        return;
+
+    std::lock_guard< std::mutex > lock( mutex );
+    if ( winner < 0 )
+    {
+        winner = i;
+        result = r;
+        stop = true;
+    }
+}
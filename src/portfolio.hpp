@@ -0,0 +1,51 @@
+#pragma once
+
+#include "base.hpp"
+#include "solver.hpp"
+#include "share.hpp"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+
+/** Diversified solvers running on the same formula in parallel threads.
+ *  They all read the long clauses of the formula from the one cnf_t and
+ *  the binary ones from binaries, the first one to finish stops the
+ *  others. */
+struct portfolio
+{
+    const cnf_t &cnf;
+    unsigned int thread_count;
+    binary_lists binaries;
+
+    std::vector< std::unique_ptr< solver > > solvers;
+
+    // Learnt clauses passed between the solvers, unless sharing is off.
+    clause_ring ring;
+    bool sharing = true;
+
+    // The configuration the diversification starts from.
+    solver_config base;
+
+    std::atomic< bool > stop = false;
+    std::mutex mutex;
+    int winner = -1;
+    sat_t result = UNKNOWN;
+
+    portfolio( const cnf_t &cnf, unsigned int thread_count );
+
+    sat_t solve();
+
+    /** The solver which found the result, solver 0 when they were all
+     *  stopped. */
+    solver &best()
+    {
+        return *solvers[ winner >= 0 ? winner : 0 ];
+    }
+
+    static solver_config config( unsigned int i, solver_config c = {} );
+
+    void run( unsigned int i );
+};
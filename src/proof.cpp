@@ -0,0 +1,263 @@
+#include "proof.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+[[noreturn]] void proof_error( const char *message )
+{
+    std::cerr << "c proof error: " << message << std::endl;
+    std::exit( 1 );
+}
+
+
+/// Proof writer //////////////////////////////////////////////////////////////
+
+
+proof_writer::proof_writer( const char *path, proof_t format ) : format( format )
+{
+    fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 )
+        proof_error( "cannot open the proof file" );
+
+    buffer.reserve( buffer_size + 1024 );
+    writer = std::thread( [this]{ write_loop(); } );
+}
+
+
+proof_writer::~proof_writer()
+{
+    hand_over();
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        closing = true;
+    }
+    changed.notify_all();
+    writer.join();
+
+    if ( close( fd ) != 0 || failed )
+        proof_error( "cannot write the proof" );
+}
+
+
+uint64_t proof_writer::add( const lit_t *first, const lit_t *last
+                          , const std::vector< uint64_t > &hints )
+{
+    uint64_t id = next_id++;
+
+    switch ( format )
+    {
+        case BINARY_DRAT:
+            put( 'a' );
+            for ( auto l = first; l != last; l++ )
+                put_lit( *l );
+            put( 0 );
+            break;
+
+        case DRAT:
+            for ( auto l = first; l != last; l++ )
+                put_lit( *l );
+            end_line();
+            break;
+
+        case LRAT:
+            put_uint( id );
+            put( ' ' );
+            for ( auto l = first; l != last; l++ )
+                put_lit( *l );
+            put( '0' );
+            for ( auto h : hints )
+            {
+                put( ' ' );
+                put_uint( h );
+            }
+            put( ' ' );
+            end_line();
+            break;
+    }
+
+    if ( buffer.size() >= buffer_size )
+        hand_over();
+    return id;
+}
+
+
+void proof_writer::remove( uint64_t id, const lit_t *first, const lit_t *last )
+{
+    switch ( format )
+    {
+        case BINARY_DRAT:
+            put( 'd' );
+            for ( auto l = first; l != last; l++ )
+                put_lit( *l );
+            put( 0 );
+            break;
+
+        case DRAT:
+            put( 'd' );
+            put( ' ' );
+            for ( auto l = first; l != last; l++ )
+                put_lit( *l );
+            end_line();
+            break;
+
+        // The id in front of a deletion only has to be at least the last
+        // one used.
+        case LRAT:
+            put_uint( next_id - 1 );
+            put( ' ' );
+            put( 'd' );
+            put( ' ' );
+            put_uint( id );
+            put( ' ' );
+            end_line();
+            break;
+    }
+
+    if ( buffer.size() >= buffer_size )
+        hand_over();
+}
+
+
+/// Output ////////////////////////////////////////////////////////////////////
+
+
+void proof_writer::put_uint( uint64_t n )
+{
+    char digits[ 20 ];
+    int count = 0;
+    do
+    {
+        digits[ count++ ] = '0' + n % 10;
+        n /= 10;
+    } while ( n != 0 );
+
+    while ( count > 0 )
+        put( digits[ --count ] );
+}
+
+
+void proof_writer::put_int( int64_t n )
+{
+    if ( n < 0 )
+    {
+        put( '-' );
+        n = -n;
+    }
+    put_uint( n );
+}
+
+
+/** Seven bits per byte starting from the lowest, the high bit is set on all
+ *  bytes but the last one. */
+void proof_writer::put_varint( uint64_t n )
+{
+    while ( n > 127 )
+    {
+        put( char( 128 | ( n & 127 ) ) );
+        n >>= 7;
+    }
+    put( char( n ) );
+}
+
+
+/** Binary DRAT maps a literal l to 2 * |l| + ( l < 0 ), text formats write
+ *  it in decimal followed by a space. */
+void proof_writer::put_lit( lit_t l )
+{
+    if ( format == BINARY_DRAT )
+        put_varint( 2 * uint64_t( l < 0 ? -l : l ) + ( l < 0 ) );
+    else
+    {
+        put_int( l );
+        put( ' ' );
+    }
+}
+
+
+void proof_writer::end_line()
+{
+    put( '0' );
+    put( '\n' );
+}
+
+
+/// Writer thread /////////////////////////////////////////////////////////////
+
+
+/** Queues the current buffer for the writer thread. Blocks when the writer
+ *  falls too far behind, so the memory used by the proof stays bounded.
+ *  Exits if the writer thread has failed. */
+void proof_writer::hand_over()
+{
+    if ( buffer.empty() )
+        return;
+
+    std::unique_lock< std::mutex > lock( mutex );
+    changed.wait( lock, [&]{ return pending.size() < max_pending || failed; } );
+    if ( failed )
+        proof_error( "cannot write the proof" );
+
+    pending.push_back( std::move( buffer ) );
+    if ( ! spare.empty() )
+    {
+        buffer = std::move( spare.back() );
+        spare.pop_back();
+    }
+    else
+    {
+        buffer = std::vector< char >();
+        buffer.reserve( buffer_size + 1024 );
+    }
+
+    lock.unlock();
+    changed.notify_all();
+}
+
+
+/** Writes the pending buffers to the file. On a failed write it drops
+ *  the rest of the proof, sets failed and stops, the owning thread exits
+ *  when it sees the flag. */
+void proof_writer::write_loop()
+{
+    std::unique_lock< std::mutex > lock( mutex );
+    while ( true )
+    {
+        changed.wait( lock, [&]{ return ! pending.empty() || closing; } );
+        if ( pending.empty() )
+            return;
+
+        std::vector< char > &out = pending.front();
+        lock.unlock();
+
+        const char *pos = out.data();
+        size_t left = out.size();
+        while ( left > 0 )
+        {
+            ssize_t n = write( fd, pos, left );
+            if ( n < 0 && errno == EINTR )
+                continue;
+            if ( n < 0 )
+                break;
+            pos += n;
+            left -= n;
+        }
+
+        lock.lock();
+        if ( left > 0 )
+        {
+            failed = true;
+            pending.clear();
+            changed.notify_all();
+            return;
+        }
+        out.clear();
+        spare.push_back( std::move( out ) );
+        pending.pop_front();
+        changed.notify_all();
+    }
+}
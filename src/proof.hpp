@@ -0,0 +1,87 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+enum proof_t
+{
+    DRAT, BINARY_DRAT, LRAT
+};
+
+/** Writes the clauses derived and deleted by the solver as a DRAT or LRAT
+ *  proof. The proof is built in memory buffers which are written to the
+ *  file by a separate thread, so the solver does not wait for the disk
+ *  unless it gets too far ahead. The proof is complete once the writer is
+ *  destroyed.
+ *
+ *  In LRAT mode every clause has an id, the clauses of the formula are
+ *  numbered from 1 in the order of the input, the derived ones follow. */
+struct proof_writer
+{
+    static constexpr size_t buffer_size = 1 << 20;
+    static constexpr size_t max_pending = 8;
+
+    proof_t format;
+    uint64_t next_id = 1;
+
+    proof_writer( const char *path, proof_t format );
+    ~proof_writer();
+
+    bool lrat() const
+    {
+        return format == LRAT;
+    }
+
+    /** Adds a derived clause, hints are the ids of the clauses which
+     *  derive it by unit propagation, in order ( LRAT only ). Returns the
+     *  id of the new clause. */
+    uint64_t add( const lit_t *first, const lit_t *last
+                , const std::vector< uint64_t > &hints );
+
+    uint64_t add( const clause_t &c, const std::vector< uint64_t > &hints )
+    {
+        return add( c.data(), c.data() + c.size(), hints );
+    }
+
+    void remove( uint64_t id, const lit_t *first, const lit_t *last );
+
+    // Output
+
+    int fd;
+    std::vector< char > buffer;
+
+    void put( char c )
+    {
+        buffer.push_back( c );
+    }
+
+    void put_uint( uint64_t n );
+    void put_int( int64_t n );
+    void put_varint( uint64_t n );
+    void put_lit( lit_t l );
+    void end_line();
+
+    // Writer thread
+
+    std::deque< std::vector< char > > pending;
+    std::vector< std::vector< char > > spare;
+    bool closing = false;
+    // Set by the writer thread when a write fails. The error is reported
+    // by the thread which owns the writer, at its next hand_over or when
+    // the writer is destroyed.
+    bool failed = false;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread writer;
+
+    void hand_over();
+    void write_loop();
+};
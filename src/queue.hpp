@@ -0,0 +1,119 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+
+/** The variable-move-to-front decision queue. The variables are kept in a
+ *  doubly linked list ordered by the time they were last bumped, which is
+ *  stamped on them, and the next decision is the most recently bumped
+ *  unassigned variable. Bumping moves a variable to the end of the list in
+ *  constant time.
+ *
+ *  search caches where the last lookup stopped: all the variables after it
+ *  are assigned. Unassigning a variable with a later stamp moves it back
+ *  there, so that lookups only walk over variables assigned since. */
+struct var_queue
+{
+    struct link_t
+    {
+        var_t prev = 0;
+        var_t next = 0;
+    };
+
+    std::vector< link_t > links;
+
+    std::vector< uint64_t > stamp;
+
+    // The least and the most recently bumped variable, 0 when empty.
+    var_t first = 0;
+    var_t last = 0;
+
+    var_t search = 0;
+
+    uint64_t stamps = 0;
+
+    size_t var_count = 0;
+
+    /** Variable 1 comes last, so that the variables are picked in the
+     *  order of their indices until they are bumped. */
+    var_queue( size_t var_count )
+    {
+        links.resize( var_count + 1 );
+        stamp.resize( var_count + 1, 0 );
+        for ( var_t v = var_count; v >= 1; v-- )
+            enqueue( v );
+        this->var_count = var_count;
+        search = last;
+    }
+
+    /** Adds the variables up to new_count as the most recently bumped
+     *  ones. They are unassigned, so the search starts from them. */
+    void resize( size_t new_count )
+    {
+        links.resize( new_count + 1 );
+        stamp.resize( new_count + 1, 0 );
+        for ( var_t v = var_count + 1; v <= new_count; v++ )
+            enqueue( v );
+        var_count = new_count;
+        search = last;
+    }
+
+    void enqueue( var_t var )
+    {
+        links[ var ] = { last, 0 };
+        if ( last != 0 )
+            links[ last ].next = var;
+        else
+            first = var;
+        last = var;
+        stamp[ var ] = ++stamps;
+    }
+
+    void dequeue( var_t var )
+    {
+        link_t l = links[ var ];
+        if ( l.prev != 0 )
+            links[ l.prev ].next = l.next;
+        else
+            first = l.next;
+        if ( l.next != 0 )
+            links[ l.next ].prev = l.prev;
+        else
+            last = l.prev;
+    }
+
+    /** Moves var to the end. An unassigned var is where the search has to
+     *  start now. */
+    void bump( var_t var, bool unassigned )
+    {
+        if ( var != last )
+        {
+            if ( search == var )
+                search = links[ var ].prev;
+            dequeue( var );
+            enqueue( var );
+        }
+        if ( unassigned )
+            search = var;
+    }
+
+    void unassign( var_t var )
+    {
+        if ( search == 0 || stamp[ var ] > stamp[ search ] )
+            search = var;
+    }
+
+    /** The most recently bumped variable which is not assigned, 0 if all
+     *  are. */
+    template< typename assigned_t >
+    var_t next( assigned_t assigned )
+    {
+        while ( search != 0 && assigned( search ) )
+            search = links[ search ].prev;
+        return search;
+    }
+};
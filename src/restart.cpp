@@ -0,0 +1,67 @@
+#include "restart.hpp"
+
+
+restart_policy::restart_policy( restart_t kind, unsigned int luby_base )
+    : kind( kind )
+    , stable( kind == LUBY || kind == GEOMETRIC )
+    , luby_gen( luby_base )
+{
+    restarted();
+}
+
+
+void restart_policy::conflict( unsigned int lbd, size_t trail )
+{
+    ++conflicts;
+    ++since_restart;
+    fast_lbd.update( lbd );
+    slow_lbd.update( lbd );
+
+    if ( ! stable && conflicts > blocking_start && since_restart >= glucose_gap
+         && trail > blocking_margin * trail_size.value() )
+    {
+        ++stats.blocked;
+        since_restart = 0;
+    }
+    trail_size.update( trail );
+
+    if ( kind == SWITCHING && conflicts >= next_switch )
+    {
+        // Each mode starts with a restart, the stable one with a fresh
+        // Luby sequence.
+        stable = ! stable;
+        ++stats.switches;
+        if ( stable )
+            luby_gen = luby( luby_gen.base_value );
+        else
+            mode_length *= 2;
+        next_switch = conflicts + mode_length;
+        switched = true;
+    }
+}
+
+
+bool restart_policy::due() const
+{
+    if ( switched )
+        return true;
+    if ( stable )
+        return since_restart >= next_restart;
+
+    return since_restart >= glucose_gap
+        && fast_lbd.value() > glucose_margin * slow_lbd.value();
+}
+
+
+void restart_policy::restarted()
+{
+    since_restart = 0;
+    switched = false;
+    if ( kind == GEOMETRIC )
+    {
+        next_restart = geometric_length;
+        geometric_length *= geometric_factor;
+    }
+    else if ( stable )
+        next_restart = luby_gen.next();
+}
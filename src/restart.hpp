@@ -0,0 +1,104 @@
+#pragma once
+
+#include "sequences.hpp"
+
+#include <cstddef>
+
+
+enum restart_t
+{
+    LUBY, GEOMETRIC, GLUCOSE, SWITCHING
+};
+
+/** Exponential moving average. Its initial zero would drag it down for
+ *  the first few hundred updates, so the value is divided by the weight
+ *  the updates have got so far. */
+struct ema
+{
+    double alpha;
+    double biased = 0;
+    double zero_weight = 1;
+
+    explicit ema( double alpha )
+        : alpha( alpha )
+    {}
+
+    void update( double y )
+    {
+        biased += alpha * ( y - biased );
+        zero_weight *= 1 - alpha;
+    }
+
+    double value() const
+    {
+        return zero_weight < 1 ? biased / ( 1 - zero_weight ) : 0;
+    }
+};
+
+struct restart_stats
+{
+    size_t blocked = 0;
+    size_t switches = 0;
+};
+
+
+/** Decides when the solver restarts, it is told about every conflict.
+ *
+ *  LUBY and GEOMETRIC restart after a given number of conflicts, the
+ *  Luby sequence times the base or a count growing by a constant factor.
+ *
+ *  GLUCOSE restarts when the recent learnt clauses are worse than usual,
+ *  ie. when a fast moving average of their lbd exceeds a slow one by a
+ *  margin. A trail much longer than its average suggests that the search
+ *  is getting close to a model, the next restart is then postponed.
+ *
+ *  SWITCHING alternates between a focused mode restarting as GLUCOSE and
+ *  a stable mode restarting as LUBY, which gives the search time to settle
+ *  on a part of the space. Each mode lasts twice as many conflicts as it
+ *  did the previous time. */
+struct restart_policy
+{
+    static constexpr size_t glucose_gap = 50;
+    static constexpr double glucose_margin = 1.1;
+    static constexpr size_t blocking_start = 10000;
+    static constexpr double blocking_margin = 1.4;
+    static constexpr double geometric_first = 100;
+    static constexpr double geometric_factor = 1.5;
+    static constexpr size_t first_mode_length = 1000;
+
+    restart_t kind;
+    restart_stats stats;
+
+    // In the stable mode of SWITCHING, LUBY and GEOMETRIC are always in it.
+    bool stable;
+
+    size_t conflicts = 0;
+    size_t since_restart = 0;
+    size_t next_restart = 0;
+
+    luby luby_gen;
+    double geometric_length = geometric_first;
+
+    ema fast_lbd { 1.0 / 32 };
+    ema slow_lbd { 1.0 / 4096 };
+    ema trail_size { 1.0 / 4096 };
+
+    size_t next_switch = first_mode_length;
+    size_t mode_length = first_mode_length;
+    bool switched = false;
+
+    restart_policy( restart_t kind, unsigned int luby_base );
+
+    /** A clause with the given lbd was learnt from a conflict with so many
+     *  literals on the trail. */
+    void conflict( unsigned int lbd, size_t trail );
+
+    bool due() const;
+
+    void restarted();
+
+    const char *mode() const
+    {
+        return stable ? "stable" : "focused";
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+
+/** Learnt clauses exported by the solvers of a portfolio for the others.
+ *
+ *  A bounded ring of fixed size slots, written and read without locks. A
+ *  writer claims the next position by incrementing head, marks the slot
+ *  busy, fills it and publishes it by storing the position + 1 as the
+ *  sequence number of the slot. Each reader has its own cursor and checks
+ *  the sequence number before and after copying a slot, because the slot
+ *  may be overwritten by a writer a whole lap ahead. Clauses older than a
+ *  lap are lost, which is fine for sharing.
+ *
+ *  A writer which finds its slot still busy with the clause of a writer a
+ *  lap behind gives up. It raises the skipped mark of the slot to the
+ *  sequence number it would have published, so that the readers do not
+ *  wait for it.
+ *
+ *  Clauses exported twice ( by different solvers ) are mostly caught by a
+ *  lossy table of the hashes of the recently exported clauses. */
+struct clause_ring
+{
+    static constexpr size_t max_size = 8;
+    static constexpr uint64_t busy = UINT64_MAX;
+
+    struct alignas( 64 ) slot_t
+    {
+        std::atomic< uint64_t > seq { 0 };
+        std::atomic< uint64_t > skipped { 0 };
+        std::atomic< uint32_t > size { 0 };
+        std::atomic< uint32_t > lbd { 0 };
+        std::atomic< uint32_t > owner { 0 };
+        std::atomic< lit_t > lits[ max_size ];
+    };
+
+    enum read_t
+    {
+        READ, SKIP, WAIT
+    };
+
+    size_t capacity;
+    std::unique_ptr< slot_t[] > slots;
+
+    size_t filter_size;
+    std::unique_ptr< std::atomic< uint64_t >[] > filter;
+
+    // Only clauses up to this lbd are exported.
+    unsigned int max_lbd = 3;
+
+    alignas( 64 ) std::atomic< uint64_t > head { 0 };
+
+    clause_ring( size_t capacity = 1 << 14, size_t filter_size = 1 << 16 )
+        : capacity( capacity )
+        , slots( new slot_t[ capacity ] )
+        , filter_size( filter_size )
+        , filter( new std::atomic< uint64_t >[ filter_size ] )
+    {
+        for ( size_t i = 0; i < filter_size; i++ )
+            filter[ i ].store( 0, std::memory_order_relaxed );
+    }
+
+    bool accepts( size_t size, unsigned int lbd ) const
+    {
+        return size <= max_size && lbd <= max_lbd;
+    }
+
+    /** Does not depend on the order of the literals. */
+    static uint64_t hash( const lit_t *first, const lit_t *last )
+    {
+        uint64_t sum = 0;
+        uint64_t x = 0;
+        for ( auto l = first; l != last; l++ )
+        {
+            uint64_t h = uint64_t( uint32_t( *l ) ) * 0x9e3779b97f4a7c15ull;
+            h ^= h >> 29;
+            h *= 0xbf58476d1ce4e5b9ull;
+            h ^= h >> 32;
+            sum += h;
+            x ^= h;
+        }
+        return sum ^ ( x << 1 | x >> 63 ) ^ ( last - first );
+    }
+
+    /** Exports the clause, returns false if it was dropped as a duplicate
+     *  or because its slot is busy or already holds a newer clause. */
+    bool push( const lit_t *first, const lit_t *last, unsigned int lbd, unsigned int owner )
+    {
+        size_t size = last - first;
+        assert( size <= max_size );
+
+        uint64_t h = hash( first, last );
+        if ( filter[ h % filter_size ].exchange( h, std::memory_order_relaxed ) == h )
+            return false;
+
+        uint64_t pos = head.fetch_add( 1, std::memory_order_relaxed );
+        slot_t &s = slots[ pos % capacity ];
+
+        uint64_t seq = s.seq.load( std::memory_order_relaxed );
+        do
+        {
+            if ( seq == busy )
+            {
+                uint64_t mark = s.skipped.load( std::memory_order_relaxed );
+                while ( mark < pos + 1
+                     && ! s.skipped.compare_exchange_weak( mark, pos + 1, std::memory_order_release
+                                                         , std::memory_order_relaxed ) )
+                    ;
+                return false;
+            }
+            // The readers skip a slot which already holds a newer clause.
+            if ( seq > pos )
+                return false;
+        } while ( ! s.seq.compare_exchange_weak( seq, busy, std::memory_order_acquire
+                                                , std::memory_order_relaxed ) );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        s.size.store( size, std::memory_order_relaxed );
+        s.lbd.store( lbd, std::memory_order_relaxed );
+        s.owner.store( owner, std::memory_order_relaxed );
+        for ( size_t i = 0; i < size; i++ )
+            s.lits[ i ].store( first[ i ], std::memory_order_relaxed );
+
+        s.seq.store( pos + 1, std::memory_order_release );
+        return true;
+    }
+
+    /** Copies the clause at position pos. WAIT means it is not written
+     *  yet, SKIP that it was lost. */
+    read_t read( uint64_t pos, clause_t &out, unsigned int &lbd, unsigned int &owner )
+    {
+        slot_t &s = slots[ pos % capacity ];
+
+        uint64_t seq = s.seq.load( std::memory_order_acquire );
+        if ( seq == busy || seq < pos + 1 )
+            return s.skipped.load( std::memory_order_acquire ) >= pos + 1 ? SKIP : WAIT;
+        if ( seq != pos + 1 )
+            return SKIP;
+
+        size_t size = std::min< size_t >( s.size.load( std::memory_order_relaxed ), max_size );
+        lbd = s.lbd.load( std::memory_order_relaxed );
+        owner = s.owner.load( std::memory_order_relaxed );
+        out.resize( size );
+        for ( size_t i = 0; i < size; i++ )
+            out[ i ] = s.lits[ i ].load( std::memory_order_relaxed );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        return s.seq.load( std::memory_order_relaxed ) == pos + 1 ? READ : SKIP;
+    }
+};
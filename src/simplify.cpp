@@ -0,0 +1,522 @@
+#include "simplify.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+
+/// Simplifier ////////////////////////////////////////////////////////////////
+
+
+simplifier::simplifier( const cnf_t &cnf, const simplify_config &config, proof_writer *proof )
+    : config( config )
+    , var_count( cnf.var_count )
+    , occurs( cnf.var_count )
+    , values( cnf.var_count + 1, val_un )
+    , frozen( cnf.var_count + 1, 0 )
+    , eliminated( cnf.var_count + 1, 0 )
+    , marks( cnf.var_count, 0 )
+    , proof( proof )
+{
+    assert( proof == nullptr || ! proof->lrat() );
+
+    stats.clauses_before = cnf.clause_count();
+    clauses.reserve( cnf.clause_count() );
+
+    // Duplicate literals are dropped and tautologies left out, the proof
+    // checkers do the same with the input.
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+    {
+        clause_t lits;
+        bool tautology = false;
+        for ( lit_t l : cnf.clause( i ) )
+        {
+            if ( marks[ -l ] )
+                tautology = true;
+            else if ( ! marks[ l ] )
+            {
+                marks[ l ] = 1;
+                lits.push_back( l );
+            }
+        }
+        for ( lit_t l : lits )
+            marks[ l ] = 0;
+
+        if ( tautology )
+            continue;
+        if ( lits.empty() )
+            unsat = true;
+        else
+            add_clause( std::move( lits ), false );
+    }
+}
+
+
+sat_t simplifier::simplify()
+{
+    auto start = std::chrono::steady_clock::now();
+    deadline = start + std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                           std::chrono::duration< double >( config.max_seconds ) );
+
+    if ( config.subsume )
+        subsume_all();
+    else
+        flush();
+
+    if ( config.eliminate )
+        while ( ! unsat && ! exhausted && eliminate_round() )
+            ;
+
+    stats.clauses_after = unsat ? 1 : units.size();
+    if ( ! unsat )
+        for ( auto &c : clauses )
+            stats.clauses_after += ! c.removed;
+
+    stats.seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    return unsat ? UNSAT : UNKNOWN;
+}
+
+
+/** Moves the formula out, only what extend needs is kept. */
+cnf_t simplifier::formula()
+{
+    cnf_t cnf;
+    cnf.var_count = var_count;
+
+    if ( unsat )
+    {
+        cnf.add_clause( {} );
+        return cnf;
+    }
+
+    for ( lit_t u : units )
+        cnf.add_clause( { u } );
+    for ( auto &c : clauses )
+        if ( ! c.removed )
+            cnf.add_clause( c.lits );
+
+    std::vector< sclause >().swap( clauses );
+    occurs = literal_map< std::vector< idx_t > >( 0 );
+    std::vector< idx_t >().swap( queue );
+    return cnf;
+}
+
+
+/** The clauses are undone in the reverse order of elimination. Each
+ *  variable starts with the value of its last entry, a unit, and is
+ *  flipped if one of its clauses would be false otherwise. The clauses of
+ *  the other sign are satisfied then by the resolvents. */
+void simplifier::extend( std::vector< val_t > &model ) const
+{
+    for ( idx_t i = extension.size(); i > 0; )
+    {
+        size_t size = extension[ --i ];
+        i -= size;
+
+        bool satisfied = false;
+        for ( size_t j = 1; j < size && ! satisfied; j++ )
+            satisfied = model[ var_of_lit( extension[ i + j ] ) ] == val_of_lit( extension[ i + j ] );
+
+        if ( ! satisfied )
+            model[ var_of_lit( extension[ i ] ) ] = val_of_lit( extension[ i ] );
+    }
+}
+
+
+void simplifier::print_stats() const
+{
+    printf( "c clauses        %zu -> %zu\n", stats.clauses_before, stats.clauses_after );
+    printf( "c simplify units %zu\n", stats.units );
+    printf( "c subsumed       %zu\n", stats.subsumed );
+    printf( "c strengthened   %zu\n", stats.strengthened );
+    printf( "c eliminated     %zu\n", stats.eliminated );
+    printf( "c resolvents     %zu\n", stats.resolvents );
+    printf( "c simplify ticks %zu%s\n", stats.ticks, exhausted ? " ( budget exhausted )" : "" );
+    printf( "c simplify time  %.2f s\n", stats.seconds );
+}
+
+
+/// Clauses ///////////////////////////////////////////////////////////////////
+
+
+void simplifier::add_clause( clause_t lits, bool derived )
+{
+    if ( derived && proof )
+        proof->add( lits, {} );
+
+    if ( lits.size() == 1 )
+    {
+        assign( lits[ 0 ] );
+        return;
+    }
+
+    idx_t c = clauses.size();
+    for ( lit_t l : lits )
+        occurs[ l ].push_back( c );
+
+    uint64_t sig = signature( lits );
+    clauses.push_back( { std::move( lits ), sig, false, config.subsume } );
+    if ( config.subsume )
+        queue.push_back( c );
+}
+
+
+void simplifier::remove_clause( idx_t c )
+{
+    sclause &s = clauses[ c ];
+    s.removed = true;
+    if ( proof )
+        proof->remove( 0, s.lits.data(), s.lits.data() + s.lits.size() );
+}
+
+
+/** Removes the literal l from the clause c. A clause left with a single
+ *  literal is replaced by a unit. */
+void simplifier::strengthen( idx_t c, lit_t l )
+{
+    sclause &s = clauses[ c ];
+
+    clause_t old;
+    if ( proof )
+        old = s.lits;
+
+    s.lits.erase( std::find( s.lits.begin(), s.lits.end(), l ) );
+
+    auto &o = occurs[ l ];
+    if ( auto it = std::find( o.begin(), o.end(), c ); it != o.end() )
+    {
+        *it = o.back();
+        o.pop_back();
+    }
+
+    if ( proof )
+    {
+        proof->add( s.lits, {} );
+        proof->remove( 0, old.data(), old.data() + old.size() );
+    }
+
+    if ( s.lits.size() == 1 )
+    {
+        s.removed = true;
+        assign( s.lits[ 0 ] );
+        return;
+    }
+
+    s.signature = signature( s.lits );
+    if ( config.subsume && ! s.queued )
+    {
+        s.queued = true;
+        queue.push_back( c );
+    }
+}
+
+
+/** The occurrences of l, without the removed clauses. */
+std::vector< idx_t > &simplifier::live( lit_t l )
+{
+    auto &o = occurs[ l ];
+    stats.ticks += o.size();
+
+    idx_t j = 0;
+    for ( idx_t c : o )
+        if ( ! clauses[ c ].removed )
+            o[ j++ ] = c;
+    o.resize( j );
+    return o;
+}
+
+
+uint64_t simplifier::signature( const clause_t &lits )
+{
+    uint64_t sig = 0;
+    for ( lit_t l : lits )
+        sig |= uint64_t( 1 ) << ( var_of_lit( l ) & 63 );
+    return sig;
+}
+
+
+/// Units /////////////////////////////////////////////////////////////////////
+
+
+void simplifier::assign( lit_t l )
+{
+    var_t v = var_of_lit( l );
+    if ( values[ v ] == val_un )
+    {
+        values[ v ] = val_of_lit( l );
+        units.push_back( l );
+        ++stats.units;
+    }
+    else if ( values[ v ] != val_of_lit( l ) )
+        unsat = true;
+}
+
+
+/** Removes the clauses satisfied by the units and the false literals
+ *  from the others. The unit clauses themselves are kept. */
+bool simplifier::propagate()
+{
+    while ( ! unsat && units_head < units.size() )
+    {
+        lit_t l = units[ units_head++ ];
+
+        for ( idx_t c : live( l ) )
+            remove_clause( c );
+        occurs[ l ].clear();
+
+        std::vector< idx_t > false_in = std::move( occurs[ -l ] );
+        occurs[ -l ].clear();
+        stats.ticks += false_in.size();
+        for ( idx_t c : false_in )
+            if ( ! clauses[ c ].removed )
+                strengthen( c, -l );
+    }
+    return ! unsat;
+}
+
+
+/// Subsumption ///////////////////////////////////////////////////////////////
+
+
+/** Checks all the clauses, the short ones first. */
+void simplifier::subsume_all()
+{
+    std::sort( queue.begin(), queue.end(), [&]( idx_t a, idx_t b ) {
+        return clauses[ a ].lits.size() > clauses[ b ].lits.size();
+    } );
+    flush();
+}
+
+
+/** Removes the clauses subsumed by c and strengthens those which c
+ *  subsumes but for one negated literal. Only the occurrences of the
+ *  variable of c with the fewest of them are searched, any clause
+ *  subsumed by c contains it too. */
+void simplifier::backward_subsume( idx_t c )
+{
+    if ( clauses[ c ].removed )
+        return;
+
+    const clause_t &lits = clauses[ c ].lits;
+    uint64_t sig = clauses[ c ].signature;
+
+    lit_t best = lits[ 0 ];
+    size_t best_count = SIZE_MAX;
+    for ( lit_t l : lits )
+    {
+        size_t count = occurs[ l ].size() + occurs[ -l ].size();
+        if ( count < best_count )
+        {
+            best = l;
+            best_count = count;
+        }
+        marks[ l ] = 1;
+    }
+
+    // Literal 0 marks a subsumed clause, any other the one to remove.
+    std::vector< std::pair< idx_t, lit_t > > found;
+    for ( lit_t p : { best, -best } )
+    {
+        for ( idx_t d : occurs[ p ] )
+        {
+            const sclause &s = clauses[ d ];
+            ++stats.ticks;
+            if ( d == c || s.removed || s.lits.size() < lits.size()
+              || ( sig & ~s.signature ) != 0 )
+                continue;
+
+            stats.ticks += s.lits.size();
+            size_t same = 0;
+            lit_t negated = 0;
+            bool fail = false;
+            for ( lit_t x : s.lits )
+            {
+                if ( marks[ x ] )
+                    ++same;
+                else if ( marks[ -x ] )
+                {
+                    if ( negated != 0 )
+                    {
+                        fail = true;
+                        break;
+                    }
+                    negated = x;
+                }
+            }
+
+            if ( ! fail && same + ( negated != 0 ) == lits.size() )
+                found.push_back( { d, negated } );
+        }
+    }
+
+    for ( lit_t l : lits )
+        marks[ l ] = 0;
+
+    for ( auto [ d, negated ] : found )
+    {
+        if ( clauses[ d ].removed )
+            continue;
+        if ( negated == 0 )
+        {
+            remove_clause( d );
+            ++stats.subsumed;
+        }
+        else
+        {
+            strengthen( d, negated );
+            ++stats.strengthened;
+        }
+    }
+}
+
+
+/** Propagates the units and checks the queued clauses for subsumption,
+ *  as long as the budget allows. */
+bool simplifier::flush()
+{
+    while ( propagate() && ! queue.empty() && ! out_of_budget() )
+    {
+        idx_t c = queue.back();
+        queue.pop_back();
+        clauses[ c ].queued = false;
+        backward_subsume( c );
+    }
+    return ! unsat;
+}
+
+
+/// Elimination ///////////////////////////////////////////////////////////////
+
+
+/** Tries to eliminate each variable once, those with fewer occurrences
+ *  first. Returns whether any was eliminated. */
+bool simplifier::eliminate_round()
+{
+    std::vector< std::pair< size_t, var_t > > candidates;
+    for ( var_t v = 1; v <= var_count; v++ )
+    {
+        if ( frozen[ v ] || eliminated[ v ] || values[ v ] != val_un )
+            continue;
+        size_t count = live( v ).size() + live( - lit_t( v ) ).size();
+        if ( count > 0 && count <= config.max_occurrences )
+            candidates.push_back( { count, v } );
+    }
+    std::sort( candidates.begin(), candidates.end() );
+
+    bool progress = false;
+    for ( auto [ count, v ] : candidates )
+    {
+        if ( out_of_budget() )
+            break;
+        if ( try_eliminate( v ) )
+        {
+            progress = true;
+            if ( ! flush() )
+                return false;
+        }
+    }
+    return progress;
+}
+
+
+/** Replaces the clauses of v by their resolvents on v, unless there are
+ *  more of those than the clauses, or one is too long. */
+bool simplifier::try_eliminate( var_t v )
+{
+    if ( values[ v ] != val_un )
+        return false;
+
+    std::vector< idx_t > pos = live( v );
+    std::vector< idx_t > neg = live( - lit_t( v ) );
+    if ( pos.size() + neg.size() > config.max_occurrences || pos.size() + neg.size() == 0 )
+        return false;
+
+    size_t limit = pos.size() + neg.size() + config.max_growth;
+    std::vector< clause_t > resolvents;
+    clause_t r;
+    for ( idx_t p : pos )
+        for ( idx_t n : neg )
+            if ( resolve( clauses[ p ].lits, clauses[ n ].lits, v, r ) )
+            {
+                if ( r.size() > config.max_resolvent || resolvents.size() == limit )
+                    return false;
+                resolvents.push_back( r );
+            }
+
+    eliminated[ v ] = 1;
+    ++stats.eliminated;
+
+    // The clauses of the sign with fewer of them are kept for extend.
+    bool keep_pos = pos.size() <= neg.size();
+    lit_t w = keep_pos ? lit_t( v ) : - lit_t( v );
+    for ( idx_t c : keep_pos ? pos : neg )
+    {
+        extension.push_back( w );
+        for ( lit_t l : clauses[ c ].lits )
+            if ( l != w )
+                extension.push_back( l );
+        extension.push_back( clauses[ c ].lits.size() );
+    }
+    extension.push_back( -w );
+    extension.push_back( 1 );
+
+    // The resolvents are derived before their antecedents are removed.
+    for ( auto &res : resolvents )
+    {
+        ++stats.resolvents;
+        add_clause( std::move( res ), true );
+    }
+    for ( idx_t c : pos )
+        remove_clause( c );
+    for ( idx_t c : neg )
+        remove_clause( c );
+    occurs[ v ].clear();
+    occurs[ - lit_t( v ) ].clear();
+    return true;
+}
+
+
+/** The resolvent of p and n on v, false if it is a tautology. */
+bool simplifier::resolve( const clause_t &p, const clause_t &n, var_t v, clause_t &out )
+{
+    stats.ticks += p.size() + n.size();
+
+    out.clear();
+    for ( lit_t l : p )
+        if ( var_of_lit( l ) != v )
+        {
+            marks[ l ] = 1;
+            out.push_back( l );
+        }
+
+    bool tautology = false;
+    for ( lit_t l : n )
+    {
+        if ( var_of_lit( l ) == v || marks[ l ] )
+            continue;
+        if ( marks[ -l ] )
+        {
+            tautology = true;
+            break;
+        }
+        out.push_back( l );
+    }
+
+    for ( lit_t l : p )
+        marks[ l ] = 0;
+    return ! tautology;
+}
+
+
+/// Budget ////////////////////////////////////////////////////////////////////
+
+
+bool simplifier::out_of_budget()
+{
+    if ( ! exhausted && stats.ticks > config.max_ticks )
+        exhausted = true;
+    if ( ! exhausted && ( ++polls & 1023 ) == 0
+         && ( std::chrono::steady_clock::now() > deadline || ( stop && *stop ) ) )
+        exhausted = true;
+    return exhausted;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "base.hpp"
+#include "proof.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+
+
+struct simplify_config
+{
+    bool subsume = true;
+    bool eliminate = true;
+
+    // The budget, ticks count the literals and occurrences visited.
+    size_t max_ticks = 1000000000;
+    double max_seconds = 10.0;
+
+    // Variables with more occurrences are not eliminated, neither are
+    // those with a resolvent longer than max_resolvent.
+    size_t max_occurrences = 64;
+    size_t max_resolvent = 32;
+
+    // Elimination may add this many clauses more than it removes.
+    size_t max_growth = 0;
+};
+
+struct simplify_stats
+{
+    size_t clauses_before = 0;
+    size_t clauses_after = 0;
+    size_t units = 0;
+    size_t subsumed = 0;
+    size_t strengthened = 0;
+    size_t eliminated = 0;
+    size_t resolvents = 0;
+    size_t ticks = 0;
+    double seconds = 0;
+};
+
+
+/** Simplifies the formula before it is given to a solver, by backward
+ *  subsumption, self-subsuming strengthening and bounded variable
+ *  elimination. The simplified formula is over the same variables,
+ *  except that the eliminated ones do not occur in it any more. A model
+ *  of it is turned into a model of the original formula by extend.
+ *
+ *  Clauses are found through occurrence lists of their literals.
+ *  Removed clauses are dropped from the lists lazily, when a list is
+ *  walked. Each clause has a signature, a bit per variable modulo 64,
+ *  which rules out most of the subsumption candidates without looking at
+ *  their literals.
+ *
+ *  The formula is equisatisfiable with the original one only, so frozen
+ *  variables are never eliminated, eg. those which are going to be
+ *  assumed or to occur in clauses added later. The derived and removed
+ *  clauses are written to a DRAT proof, LRAT is not supported. */
+struct simplifier
+{
+    struct sclause
+    {
+        clause_t lits;
+        uint64_t signature = 0;
+        bool removed = false;
+        bool queued = false;
+    };
+
+    simplify_config config;
+    simplify_stats stats;
+
+    unsigned int var_count;
+    std::vector< sclause > clauses;
+    literal_map< std::vector< idx_t > > occurs;
+
+    // Level 0 assignment, the units are kept apart from the clauses.
+    std::vector< val_t > values;
+    std::vector< lit_t > units;
+    idx_t units_head = 0;
+    bool unsat = false;
+
+    std::vector< char > frozen;
+    std::vector< char > eliminated;
+
+    /** The clauses needed to extend a model, each is followed by its size
+     *  and begins with the literal set to satisfy it. */
+    std::vector< lit_t > extension;
+
+    // Clauses to be subsumption checked against the others.
+    std::vector< idx_t > queue;
+
+    literal_map< char > marks;
+
+    proof_writer *proof;
+
+    simplifier( const cnf_t &cnf, const simplify_config &config = {}
+              , proof_writer *proof = nullptr );
+
+    void freeze( var_t v )
+    {
+        frozen[ v ] = 1;
+    }
+
+    /** UNSAT if the formula turned out to be unsatisfiable, UNKNOWN
+     *  otherwise. */
+    sat_t simplify();
+
+    /** The simplified formula. */
+    cnf_t formula();
+
+    /** Sets the eliminated variables in a model of the simplified formula
+     *  ( values indexed by variables ) so that it satisfies the original
+     *  one. */
+    void extend( std::vector< val_t > &model ) const;
+
+    void print_stats() const;
+
+    // Clauses
+
+    void add_clause( clause_t lits, bool derived );
+    void remove_clause( idx_t c );
+    void strengthen( idx_t c, lit_t l );
+    std::vector< idx_t > &live( lit_t l );
+
+    static uint64_t signature( const clause_t &lits );
+
+    // Units
+
+    void assign( lit_t l );
+    bool propagate();
+
+    // Subsumption
+
+    void subsume_all();
+    void backward_subsume( idx_t c );
+    bool flush();
+
+    // Elimination
+
+    bool eliminate_round();
+    bool try_eliminate( var_t v );
+    bool resolve( const clause_t &p, const clause_t &n, var_t v, clause_t &out );
+
+    // Budget
+
+    std::chrono::steady_clock::time_point deadline;
+    size_t polls = 0;
+    bool exhausted = false;
+
+    // Set by another thread to stop the simplification early, what is
+    // done so far stays valid.
+    const std::atomic< bool > *stop = nullptr;
+
+    bool out_of_budget();
+};
@@ -0,0 +1,286 @@
+#include "sls.hpp"
+#include "timer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+
+/// Local search ///////////////////////////////////////////////////////////////
+
+
+/** Duplicate literals are dropped, so are tautologies, otherwise the xor
+ *  of the true variables would not identify the breaking one. */
+local_search::local_search( const cnf_t &cnf, const sls_config &config )
+    : config( config )
+    , var_count( cnf.var_count )
+    , random_state( config.seed * 0x9E3779B97F4A7C15ull + 1 )
+{
+    std::vector< lit_t > seen( var_count + 1, 0 );
+    literals.reserve( cnf.literals.size() );
+    start.reserve( cnf.clause_count() + 1 );
+    start.push_back( 0 );
+
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+    {
+        size_t first = literals.size();
+        bool tautology = false;
+        for ( lit_t l : cnf.clause( i ) )
+        {
+            lit_t &s = seen[ var_of_lit( l ) ];
+            if ( s == -l )
+                tautology = true;
+            else if ( s != l )
+            {
+                s = l;
+                literals.push_back( l );
+            }
+        }
+        for ( size_t j = first; j < literals.size(); j++ )
+            seen[ var_of_lit( literals[ j ] ) ] = 0;
+
+        if ( tautology )
+            literals.resize( first );
+        else
+        {
+            empty_clause |= literals.size() == first;
+            start.push_back( literals.size() );
+        }
+    }
+
+    size_t clause_count = start.size() - 1;
+    occurs_start.resize( 2 * size_t( var_count ) + 3, 0 );
+    for ( lit_t l : literals )
+        ++occurs_start[ index( l ) + 1 ];
+    for ( size_t i = 1; i < occurs_start.size(); i++ )
+        occurs_start[ i ] += occurs_start[ i - 1 ];
+
+    occurs.resize( literals.size() );
+    std::vector< size_t > fill( occurs_start.begin(), occurs_start.end() - 1 );
+    for ( uint32_t c = 0; c < clause_count; c++ )
+        for ( size_t j = start[ c ]; j < start[ c + 1 ]; j++ )
+            occurs[ fill[ index( literals[ j ] ) ]++ ] = c;
+
+    value.resize( var_count + 1, 0 );
+    true_count.resize( clause_count, 0 );
+    true_xor.resize( clause_count, 0 );
+    unsat_pos.resize( clause_count, 0 );
+    break_count.resize( var_count + 1, 0 );
+
+    // The ProbSAT parameters: polynomial for 3-SAT, exponential with a
+    // base growing with the clause length otherwise.
+    double average = clause_count == 0 ? 0.0 : double( literals.size() ) / clause_count;
+    probability.resize( 64 );
+    for ( size_t b = 0; b < probability.size(); b++ )
+    {
+        if ( average <= 3.5 )
+            probability[ b ] = std::pow( 1.0 + b, -2.38 );
+        else
+        {
+            double base = average <= 4.5 ? 3.0 : average <= 5.5 ? 3.7 : average <= 6.5 ? 5.1 : 5.4;
+            probability[ b ] = std::pow( base, - double( b ) );
+        }
+    }
+}
+
+
+void local_search::assign( const std::vector< val_t > &initial )
+{
+    for ( var_t v = 1; v <= var_count; v++ )
+    {
+        val_t phase = v < initial.size() ? initial[ v ] : val_un;
+        value[ v ] = phase == val_un ? next_random() & 1 : phase == val_tt;
+    }
+
+    std::fill( true_count.begin(), true_count.end(), 0 );
+    std::fill( true_xor.begin(), true_xor.end(), 0 );
+    std::fill( break_count.begin(), break_count.end(), 0 );
+    unsat.clear();
+
+    for ( uint32_t c = 0; c + 1 < start.size(); c++ )
+    {
+        for ( size_t j = start[ c ]; j < start[ c + 1 ]; j++ )
+            if ( is_true( literals[ j ] ) )
+            {
+                ++true_count[ c ];
+                true_xor[ c ] ^= var_of_lit( literals[ j ] );
+            }
+
+        if ( true_count[ c ] == 0 )
+            make_unsat( c );
+        else if ( true_count[ c ] == 1 )
+            ++break_count[ true_xor[ c ] ];
+    }
+
+    stats.best_unsat = unsat.size();
+    tracking = true;
+    flips_since_best.clear();
+}
+
+void local_search::assign_random()
+{
+    assign( {} );
+}
+
+
+sat_t local_search::walk()
+{
+    if ( empty_clause )
+        return UNSAT;
+
+    clock_type::time_point started = clock_type::now();
+    std::vector< double > weights;
+    size_t flips = 0;
+
+    while ( ! unsat.empty() )
+    {
+        if ( config.max_flips > 0 && flips >= config.max_flips )
+            break;
+        if ( ( flips & 0x3fff ) == 0x3fff )
+        {
+            if ( stop && *stop )
+                break;
+            if ( config.max_seconds > 0 && seconds_since( started ) >= config.max_seconds )
+                break;
+        }
+
+        uint32_t c = unsat[ next_random() % unsat.size() ];
+        size_t first = start[ c ], size = start[ c + 1 ] - first;
+
+        weights.resize( size );
+        double sum = 0;
+        for ( size_t j = 0; j < size; j++ )
+        {
+            uint32_t b = break_count[ var_of_lit( literals[ first + j ] ) ];
+            weights[ j ] = probability[ std::min< size_t >( b, probability.size() - 1 ) ];
+            sum += weights[ j ];
+        }
+
+        double r = ( next_random() >> 11 ) * 0x1.0p-53 * sum;
+        size_t pick = 0;
+        while ( pick + 1 < size && r >= weights[ pick ] )
+            r -= weights[ pick++ ];
+
+        var_t v = var_of_lit( literals[ first + pick ] );
+        flip( v );
+        ++flips;
+
+        if ( unsat.size() < stats.best_unsat )
+        {
+            stats.best_unsat = unsat.size();
+            tracking = true;
+            flips_since_best.clear();
+        }
+        else if ( tracking )
+        {
+            flips_since_best.push_back( v );
+            if ( flips_since_best.size() > var_count / 4 + 1024 )
+                save_best();
+        }
+    }
+
+    stats.flips += flips;
+    stats.seconds += seconds_since( started );
+    return unsat.empty() ? SAT : UNKNOWN;
+}
+
+
+/** The clauses of the literal made true gain a true literal, those of the
+ *  other one lose it. */
+void local_search::flip( var_t v )
+{
+    value[ v ] ^= 1;
+    lit_t now_true = value[ v ] ? lit_t( v ) : - lit_t( v );
+
+    size_t i = index( now_true );
+    for ( size_t j = occurs_start[ i ]; j < occurs_start[ i + 1 ]; j++ )
+    {
+        uint32_t c = occurs[ j ];
+        if ( true_count[ c ] == 0 )
+        {
+            make_sat( c );
+            ++break_count[ v ];
+        }
+        else if ( true_count[ c ] == 1 )
+            --break_count[ true_xor[ c ] ];
+        ++true_count[ c ];
+        true_xor[ c ] ^= v;
+    }
+
+    i = index( - now_true );
+    for ( size_t j = occurs_start[ i ]; j < occurs_start[ i + 1 ]; j++ )
+    {
+        uint32_t c = occurs[ j ];
+        --true_count[ c ];
+        true_xor[ c ] ^= v;
+        if ( true_count[ c ] == 0 )
+        {
+            make_unsat( c );
+            --break_count[ v ];
+        }
+        else if ( true_count[ c ] == 1 )
+            ++break_count[ true_xor[ c ] ];
+    }
+}
+
+void local_search::make_unsat( uint32_t c )
+{
+    unsat_pos[ c ] = unsat.size();
+    unsat.push_back( c );
+}
+
+void local_search::make_sat( uint32_t c )
+{
+    uint32_t last = unsat.back();
+    unsat[ unsat_pos[ c ] ] = last;
+    unsat_pos[ last ] = unsat_pos[ c ];
+    unsat.pop_back();
+}
+
+
+/** Stores the best assignment when the flips since it get too many to
+ *  undo at the end. */
+void local_search::save_best()
+{
+    best = value;
+    for ( var_t v : flips_since_best )
+        best[ v ] ^= 1;
+    flips_since_best.clear();
+    tracking = false;
+}
+
+std::vector< val_t > local_search::best_values() const
+{
+    std::vector< char > values = tracking ? value : best;
+    if ( tracking )
+        for ( var_t v : flips_since_best )
+            values[ v ] ^= 1;
+
+    std::vector< val_t > model( var_count + 1, val_un );
+    for ( var_t v = 1; v <= var_count; v++ )
+        model[ v ] = values[ v ] ? val_tt : val_ff;
+    return model;
+}
+
+
+/// Statistics /////////////////////////////////////////////////////////////////
+
+
+void local_search::print_stats() const
+{
+    printf( "c sls time       %.2f s\n", stats.seconds );
+    printf( "c flips          %zu (%.0f per second)\n", stats.flips
+          , stats.seconds > 0 ? stats.flips / stats.seconds : 0.0 );
+    printf( "c best unsat     %zu\n", stats.best_unsat );
+}
+
+void local_search::write_json( std::ostream &out, int indent ) const
+{
+    std::string pad( indent, ' ' );
+    out << "{\n"
+        << pad << "\"seconds\": " << stats.seconds << ",\n"
+        << pad << "\"flips\": " << stats.flips << ",\n"
+        << pad << "\"best_unsat\": " << stats.best_unsat << "\n"
+        << std::string( std::max( indent - 4, 0 ), ' ' ) << "}";
+}
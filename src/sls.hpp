@@ -0,0 +1,127 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <ostream>
+
+
+struct sls_config
+{
+    uint64_t seed = 0;
+
+    // Limits of one call of walk, 0 for none.
+    size_t max_flips = 0;
+    double max_seconds = 0;
+};
+
+struct sls_stats
+{
+    size_t flips = 0;
+    size_t best_unsat = 0;
+    double seconds = 0;
+};
+
+
+/** ProbSAT local search. Starting from a full assignment, it repeatedly
+ *  picks a random falsified clause and flips one of its variables, chosen
+ *  with a probability which falls exponentially ( polynomially for
+ *  3-SAT ) with the break count of the variable, the number of clauses it
+ *  alone satisfies.
+ *
+ *  The clauses are copied into one flat array with occurrence lists of
+ *  their literals. Each clause keeps the number of its true literals and
+ *  the xor of their variables, which is the variable that breaks it when
+ *  there is only one. A flip walks the occurrence lists of the two
+ *  literals of the variable and updates these, the break counts and the
+ *  list of falsified clauses in constant time per occurrence.
+ *
+ *  Incomplete: it finds models of satisfiable formulas, never proves
+ *  unsatisfiability, except that of an empty clause. */
+struct local_search
+{
+    sls_config config;
+    sls_stats stats;
+
+    unsigned int var_count;
+
+    // Clause c is literals[ start[ c ] ] up to literals[ start[ c + 1 ] ].
+    std::vector< lit_t > literals;
+    std::vector< size_t > start;
+    bool empty_clause = false;
+
+    // occurs[ occurs_start[ index( l ) ] ... ] are the clauses of l.
+    std::vector< uint32_t > occurs;
+    std::vector< size_t > occurs_start;
+
+    std::vector< char > value;
+    std::vector< uint32_t > true_count;
+    std::vector< var_t > true_xor;
+    std::vector< uint32_t > break_count;
+
+    std::vector< uint32_t > unsat;
+    std::vector< uint32_t > unsat_pos;
+
+    // The assignment with the fewest falsified clauses. While tracking, it
+    // is the current one with the flips since undone, otherwise it is
+    // kept in best.
+    std::vector< char > best;
+    std::vector< var_t > flips_since_best;
+    bool tracking = false;
+
+    // Flip probabilities by break count.
+    std::vector< double > probability;
+
+    uint64_t random_state;
+
+    const std::atomic< bool > *stop = nullptr;
+
+    local_search( const cnf_t &cnf, const sls_config &config = {} );
+
+    /** Starts from the given values ( indexed by variables, val_un for a
+     *  random one ). */
+    void assign( const std::vector< val_t > &initial );
+
+    /** Random values for all variables. */
+    void assign_random();
+
+    /** Flips until all clauses are satisfied ( SAT ), the empty clause is
+     *  found ( UNSAT ) or a limit or stop is reached ( UNKNOWN ). */
+    sat_t walk();
+
+    /** The best assignment found, indexed by variables. */
+    std::vector< val_t > best_values() const;
+
+    void print_stats() const;
+
+    void write_json( std::ostream &out, int indent = 4 ) const;
+
+    static size_t index( lit_t l )
+    {
+        return 2 * size_t( var_of_lit( l ) ) + ( l < 0 );
+    }
+
+    bool is_true( lit_t l ) const
+    {
+        return value[ var_of_lit( l ) ] == ( l > 0 );
+    }
+
+    uint64_t next_random()
+    {
+        // xorshift64*
+        random_state ^= random_state >> 12;
+        random_state ^= random_state << 25;
+        random_state ^= random_state >> 27;
+        return random_state * 2685821657736338717ull;
+    }
+
+    void flip( var_t v );
+
+    void make_unsat( uint32_t c );
+
+    void make_sat( uint32_t c );
+
+    void save_best();
+};
@@ -1,14 +1,19 @@
 #include "solver.hpp"
 #include <cassert>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <sys/resource.h>
 #include "logger.hpp"
 
-/// Global ////////////////////////////////////////////////////////////////////
+/// Global /////////////////////////////////////////////////////////////////////
 
 
 logger_t logger;
 
 
-/// Misc. /////////////////////////////////////////////////////////////////////
+/// Misc. //////////////////////////////////////////////////////////////////////
 
 
 void log_trail( const char *message, solver& s )
@@ -20,40 +25,210 @@ void log_trail( const char *message, solver& s )
 }
 
 
-/// Solver ////////////////////////////////////////////////////////////////////
+/// Solver /////////////////////////////////////////////////////////////////////
 
 
-solver::solver( cnf_t cnf ) : var_count( cnf.var_count )
-                            , clauses( std::move( cnf.clauses ) )
+solver::solver( const cnf_t &cnf, const solver_config &config, proof_writer *proof )
+                            : limits( config.limits )
+                            , var_count( cnf.var_count )
+                            , clauses( {} )
+                            , chrono_levels( config.chrono_levels )
                             , watched_in( cnf.var_count )
+                            , binary_in( cnf.var_count )
                             , lit_level( cnf.var_count, -1 )
-                            , reason( cnf.var_count, idx_undef )
+                            , reason( cnf.var_count, reason_t() )
                             , to_resolve( cnf.var_count )
                             , learnt_lit( cnf.var_count )
+                            , heuristic( config.heuristic )
                             , heap( cnf.var_count )
-                            , luby_gen( 420 )
-                            , conflict_count( 0 )
+                            , bump_step( config.bump_step )
+                            , queue( cnf.var_count )
+                            , restarts( config.restarts, config.luby_base )
+                            , inprocessing( config.inprocess )
+                            , inprocess_effort( config.inprocess_effort )
+                            , target_mode( config.target_phases )
+                            , rephase_interval( config.rephase_interval )
+                            , next_rephase( config.rephase_interval )
+                            , phase_random( config.seed )
+                            , walk_effort( config.walk_effort )
+                            , proof( proof )
+                            , binary_ids( 0 )
+                            , start_time( clock_type::now() )
+                            , profiling( config.profile )
+                            , report_interval( config.report_interval )
+                            , next_report( config.report_interval )
 {
     values.resize( cnf.var_count + 1, val_un );
-    phases.resize( cnf.var_count + 1, val_tt );
+    phases.resize( cnf.var_count + 1, config.phase );
+    target_phases.resize( cnf.var_count + 1, val_un );
+    best_phases.resize( cnf.var_count + 1, val_un );
+    level_stamp.resize( cnf.var_count + 1, 0 );
 
-    for ( idx_t i = 0; i < clauses.count; i++ )
+    if ( config.seed != 0 || config.phase == val_un )
     {
-        assert( clauses.size( i ) != 0 );
-        watched_in[ clauses( i, 0 ) ].push_back( i );
-        if ( clauses.size(i) > 1 )
-            watched_in[ clauses( i, 1 ) ].push_back( i );
+        std::mt19937 random( config.seed );
+        for ( var_t v = 1; v <= var_count; v++ )
+        {
+            if ( config.seed != 0 )
+                heap.set_priority( v, std::uniform_real_distribution<>( 0.0, 1e-3 )( random ) );
+            if ( config.phase == val_un )
+                phases[ v ] = random() & 1 ? val_tt : val_ff;
+        }
+    }
+
+    // The queue starts in the same order as the heap.
+    if ( config.seed != 0 && keep_queue() )
+    {
+        std::vector< var_t > order;
+        for ( var_t v = 1; v <= var_count; v++ )
+            order.push_back( v );
+        std::stable_sort( order.begin(), order.end(), [&]( var_t a, var_t b ) {
+            return heap.priority( a ) < heap.priority( b ); } );
+        for ( var_t v : order )
+            queue.bump( v, true );
+    }
+
+    if ( config.share_formula )
+    {
+        clauses.shared_lits = cnf.literals.data();
+        formula_binaries = config.formula_binaries;
+    }
+
+    // The clauses of the formula have ids 1 to clause_count.
+    if ( proof )
+    {
+        proof->next_id = cnf.clause_count() + 1;
+        lrat = proof->lrat();
+    }
+    assert( ! lrat || ! formula_binaries );
+    if ( lrat )
+    {
+        clauses.trailer = 2;
+        binary_ids = literal_map< std::vector< uint64_t > >( cnf.var_count );
+        unit_id.resize( cnf.var_count + 1, 0 );
+        hint_mark.resize( cnf.var_count + 1, 0 );
+    }
+
+    // Tautologies are dropped, shrinking them at level 0 would not keep
+    // them satisfied.
+    std::vector< lit_t > seen( cnf.var_count + 1, 0 );
+    auto tautology = [&]( clause_view c ) {
+        bool found = false;
+        for ( lit_t l : c )
+        {
+            found |= seen[ var_of_lit( l ) ] == -l;
+            seen[ var_of_lit( l ) ] = l;
+        }
+        for ( lit_t l : c )
+            seen[ var_of_lit( l ) ] = 0;
+        return found;
+    };
+
+    // The arena grows only once.
+    size_t words = 0;
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+    {
+        size_t size = cnf.offsets[ i + 1 ] - cnf.offsets[ i ];
+        if ( size > 2 )
+            words += ( config.share_formula ? clause_arena::shared_size
+                                            : clause_arena::header_size + size ) + clauses.trailer;
+    }
+    clauses.memory.reserve( words );
+
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+    {
+        clause_view c = cnf.clause( i );
+        if ( c.size() > 1 && tautology( c ) )
+            continue;
+        if ( c.size() == 0 )
+        {
+            empty_clause = true;
+            empty_clause_id = i + 1;
+        }
+        else if ( c.size() == 1 )
+        {
+            units.push_back( c[ 0 ] );
+            if ( lrat )
+                unit_clause_ids.push_back( i + 1 );
+        }
+        else if ( c.size() == 2 )
+        {
+            if ( ! formula_binaries )
+                add_binary( c[ 0 ], c[ 1 ], i + 1 );
+        }
+        else
+        {
+            cref_t i_c = config.share_formula
+                       ? clauses.add_shared( cnf.offsets[ i ], c.size() )
+                       : clauses.add( c.begin(), c.end() );
+            if ( lrat )
+                clauses.set_id( i_c, i + 1 );
+        }
     }
 
-    next_restart = luby_gen.next();
+    for ( cref_t i = clauses.begin(); i != clauses.end(); i = clauses.next( i ) )
+    {
+        assert( clauses.size( i ) > 2 );
+        attach( i );
+    }
 }
 
 
-sat_t solver::solve()
+solver::solver( unsigned int var_count, const solver_config &config )
+    : solver( cnf_t { {}, { 0 }, var_count }, config )
+{}
+
+
+/** Searches for a model in which all the assumptions are true. UNSAT
+ *  means that there is none, the formula itself is unsatisfiable if
+ *  inconsistent is set as well. Gives up with UNKNOWN after max_conflicts.
+ *  Can be called repeatedly, the learnt clauses are kept. */
+sat_t solver::solve( const std::vector< lit_t > &assumed, size_t max_conflicts )
 {
-    for ( idx_t i_c = 0; i_c < clauses.count; i_c++ )
-        if ( clauses.size( i_c ) == 1 )
-            unit_queue.push_back( i_c );
+    scoped_timer solve_timer( &solve_seconds );
+    core.clear();
+    if ( inconsistent )
+        return UNSAT;
+
+    backtrack( 0 );
+
+    // An assumption may be on a variable no clause mentions yet.
+    for ( lit_t a : assumed )
+        if ( var_of_lit( a ) > var_count )
+            grow( var_of_lit( a ) );
+
+    // Replaced variables are assumed through their representatives, the
+    // core is given in the original assumptions.
+    std::vector< lit_t > assumptions = assumed;
+    for ( lit_t &a : assumptions )
+        a = representative( a );
+    auto fail = [&]( lit_t a ) {
+        analyze_final( a );
+        for ( lit_t &c : core )
+            c = assumed[ std::find( assumptions.begin(), assumptions.end(), c ) - assumptions.begin() ];
+        return UNSAT;
+    };
+
+    if ( empty_clause )
+    {
+        hints.assign( 1, empty_clause_id );
+        derive_empty();
+        inconsistent = true;
+        return UNSAT;
+    }
+
+    if ( ! assign_units() )
+    {
+        inconsistent = true;
+        return UNSAT;
+    }
+
+    size_t conflict_limit = max_conflicts == SIZE_MAX ? SIZE_MAX
+                                                      : stats.conflicts + max_conflicts;
+    if ( limits.conflicts > 0 )
+        conflict_limit = std::min( conflict_limit, limits.conflicts );
+    limit_reached = false;
+    next_poll = stats.propagations;
 
     while ( true )
     {
@@ -61,60 +236,504 @@ sat_t solver::solve()
         log_trail( "new cycle", *this );
         // logger.log( "decisions", "%d", decisions.size() );
 
-        if ( sidx_t i_c = unit_propagation(); i_c != idx_undef )
+        sidx_t i_c;
+        {
+            scoped_timer t( timer( PROPAGATION ) );
+            i_c = unit_propagation();
+        }
+
+        if ( stats.propagations >= next_poll && ! poll() )
+            return UNKNOWN;
+
+        if ( i_c != idx_undef )
         {
             // logger.log( "conflict", clauses[ i_c ] );
-            ++conflict_count;
+            ++total_conflicts;
+            ++stats.conflicts;
+
+            if ( stopped() )
+                return UNKNOWN;
+
+            lit_t forced = 0;
+            sidx_t level = chrono_levels > 0 ? conflict_level( i_c, forced ) : decision_level;
+            if ( level == 0 )
+            {
+                if ( lrat )
+                    collect_hints( {}, i_c );
+                derive_empty();
+                inconsistent = true;
+                return UNSAT;
+            }
+
+            size_t conflict_trail = trail.size();
+            update_phases();
+
+            // A conflict with one literal at its level only shows that the
+            // literal was not implied where it should have been.
+            if ( forced != 0 )
+            {
+                auto [ a, b ] = binary_conflict;
+                reason_t why = i_c != idx_binary ? reason_t { i_c, 0 }
+                                                 : reason_t { idx_undef, forced == a ? b : a };
+                backtrack( level - 1 );
+                assign( forced, why, reason_level( forced, why ) );
+                continue;
+            }
 
-            if ( decisions.empty() ) return UNSAT;
-            unit_queue.clear();
+            {
+                scoped_timer t( timer( ANALYSIS ) );
+                backtrack( level );
+                auto [ new_clause, jump_level ] = conflict_anal( i_c );
+
+                lit_t asserted = new_clause[ 0 ];
+                sidx_t target_level = jump_level;
+                if ( chrono_levels > 0 && new_clause.size() > 1
+                     && decision_level - jump_level > chrono_levels )
+                {
+                    target_level = decision_level - 1;
+                    ++stats.chrono_backtracks;
+                    stats.chrono_kept += decisions[ target_level ] - decisions[ jump_level ];
+                }
 
-            auto [ new_clause, target_level ] = conflict_anal( i_c );
+                reason_t new_reason = learn( std::move( new_clause ) );
+                backtrack( target_level );
+                assign( asserted, new_reason, jump_level );
+            }
+            restarts.conflict( learnt_lbd, conflict_trail );
 
-            idx_t i_new_clause = learn( std::move( new_clause ) );
-            // logger.log( "new_clause", clauses[ i_new_clause ] );
-            if ( conflict_count >= next_restart )
+            // The passes below run after a restart, but on their own
+            // schedule, the policy may not restart for a long time.
+            if ( restarts.due() || pass_due() )
             {
                 logger.log( "restart" );
-                if ( target_level == 0 )
-                    unit_queue.push_back( i_new_clause );
                 restart();
+                if ( rephase_interval > 0 && stats.conflicts >= next_rephase )
+                    rephase();
+                if ( share && ! import_shared() )
+                {
+                    inconsistent = true;
+                    return UNSAT;
+                }
+                if ( inprocessing && stats.conflicts >= next_inprocess )
+                {
+                    if ( ! inprocess() )
+                        return UNSAT;
+                    for ( lit_t &a : assumptions )
+                        a = representative( a );
+                }
             }
-            else
+
+            if ( stats.conflicts >= conflict_limit )
             {
-                backtrack( target_level );
-                unit_queue.push_back( i_new_clause );
+                limit_reached = limits.conflicts > 0 && stats.conflicts >= limits.conflicts;
+                return UNKNOWN;
             }
             continue;
         }
 
-        lit_t l = pick_literal();
+        if ( stopped() )
+            return UNKNOWN;
+
+        if ( total_conflicts >= next_reduce )
+            reduce_db();
+
+        // The assumptions are decided first, in their order.
+        lit_t l = 0;
+        for ( lit_t a : assumptions )
+        {
+            val_t v = eval_lit( a );
+            if ( v == val_ff )
+                return fail( a );
+            if ( v == val_un )
+            {
+                l = a;
+                break;
+            }
+        }
+
+        if ( l == 0 )
+            l = pick_literal();
         if ( l == 0 )
             break;
 
         logger.log( "pick", "%d", l );
         decide( l );
     }
+
+    for ( var_t v = 1; v < substitute.size(); v++ )
+        if ( substitute[ v ] != 0 )
+            values[ v ] = eval_lit( substitute[ v ] );
     return SAT;
 }
 
 
-/// Picking literal ///////////////////////////////////////////////////////////
+/// Statistics /////////////////////////////////////////////////////////////////
+
+
+static const char *phase_names[ PHASE_COUNT ] = {
+    "propagation", "analysis", "restarts", "reduction", "inprocessing", "local search"
+};
+
+
+void solver::print_stats()
+{
+    auto ratio = []( size_t a, size_t b ) {
+        return b == 0 ? 0.0 : 100.0 * double( a ) / double( b );
+    };
+
+    auto per_second = [&]( size_t n ) {
+        return solve_seconds > 0 ? double( n ) / solve_seconds : 0.0;
+    };
+
+    printf( "c solve time     %.2f s\n", solve_seconds );
+    printf( "c conflicts      %zu (%.0f per second)\n"
+          , stats.conflicts, per_second( stats.conflicts ) );
+    printf( "c decisions      %zu\n", stats.decisions );
+    printf( "c propagations   %zu (%.0f per second)\n"
+          , stats.propagations, per_second( stats.propagations ) );
+    printf( "c binary props   %zu\n", stats.binary_propagations );
+    printf( "c restarts       %zu\n", stats.restarts );
+    printf( "c blocked        %zu\n", restarts.stats.blocked );
+    printf( "c mode switches  %zu\n", restarts.stats.switches );
+    printf( "c reused levels  %zu\n", stats.reused_levels );
+    printf( "c chrono         %zu (%zu assignments kept)\n"
+          , stats.chrono_backtracks, stats.chrono_kept );
+    printf( "c rephases       %zu\n", stats.rephases );
+    printf( "c walks          %zu (%zu flips, %.0f per second)\n", stats.walks, stats.walk_flips
+          , stats.walk_seconds > 0 ? stats.walk_flips / stats.walk_seconds : 0.0 );
+    printf( "c reductions     %zu\n", stats.reductions );
+    printf( "c learnt lits    %zu\n", stats.learnt_literals );
+    printf( "c minimized lits %zu (%.2f per conflict, %.2f %%)\n"
+          , stats.minimized_literals
+          , stats.conflicts == 0 ? 0.0 : double( stats.minimized_literals ) / stats.conflicts
+          , ratio( stats.minimized_literals, stats.minimized_literals + stats.learnt_literals ) );
+    printf( "c watcher visits %zu\n", stats.watcher_visits );
+    printf( "c blocker hits   %zu (%.2f %%)\n"
+          , stats.blocker_hits, ratio( stats.blocker_hits, stats.watcher_visits ) );
+    if ( share )
+    {
+        printf( "c exported       %zu\n", stats.exported );
+        printf( "c imported       %zu\n", stats.imported );
+    }
+    printf( "c inprocessings  %zu\n", stats.inprocessings );
+    printf( "c failed lits    %zu\n", stats.failed_literals );
+    printf( "c vivified       %zu (%zu lits)\n", stats.vivified, stats.vivified_literals );
+    printf( "c substituted    %zu\n", stats.substituted );
+    printf( "c long clauses   %zu (%zu learnt)\n", clauses.count, clauses.learnt_count );
+    printf( "c binary clauses %zu\n", binary_count() );
+
+    if ( profiling )
+        for ( int p = 0; p < PHASE_COUNT; p++ )
+            printf( "c %-15s%.2f s (%.2f %%)\n", phase_names[ p ], phase_seconds[ p ]
+                  , solve_seconds > 0 ? 100.0 * phase_seconds[ p ] / solve_seconds : 0.0 );
+}
+
+
+void solver::write_json( std::ostream &out, int indent )
+{
+    std::string pad( indent, ' ' );
+    const char *separator = "{\n";
+    auto field = [&]( const char *name, auto value ) {
+        out << separator << pad << "\"" << name << "\": " << value;
+        separator = ",\n";
+    };
+
+    field( "seconds", solve_seconds );
+    field( "conflicts", stats.conflicts );
+    field( "decisions", stats.decisions );
+    field( "propagations", stats.propagations );
+    field( "binary_propagations", stats.binary_propagations );
+    field( "restarts", stats.restarts );
+    field( "blocked_restarts", restarts.stats.blocked );
+    field( "mode_switches", restarts.stats.switches );
+    field( "reused_levels", stats.reused_levels );
+    field( "chrono_backtracks", stats.chrono_backtracks );
+    field( "chrono_kept", stats.chrono_kept );
+    field( "rephases", stats.rephases );
+    field( "walks", stats.walks );
+    field( "walk_flips", stats.walk_flips );
+    field( "walk_seconds", stats.walk_seconds );
+    field( "reductions", stats.reductions );
+    field( "learnt_literals", stats.learnt_literals );
+    field( "minimized_literals", stats.minimized_literals );
+    field( "watcher_visits", stats.watcher_visits );
+    field( "blocker_hits", stats.blocker_hits );
+    field( "exported", stats.exported );
+    field( "imported", stats.imported );
+    field( "inprocessings", stats.inprocessings );
+    field( "failed_literals", stats.failed_literals );
+    field( "vivified", stats.vivified );
+    field( "vivified_literals", stats.vivified_literals );
+    field( "substituted", stats.substituted );
+    field( "long_clauses", clauses.count );
+    field( "learnt_clauses", clauses.learnt_count );
+    field( "binary_clauses", binary_count() );
+
+    if ( profiling )
+    {
+        out << separator << pad << "\"profile\": {";
+        for ( int p = 0; p < PHASE_COUNT; p++ )
+            out << ( p == 0 ? " " : ", " ) << "\"" << phase_names[ p ] << "\": "
+                << phase_seconds[ p ];
+        out << " }";
+    }
+    out << "\n" << std::string( std::max( indent - 4, 0 ), ' ' ) << "}";
+}
+
+
+static size_t peak_memory_mb()
+{
+    rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss / 1024;
+}
+
+
+/** Checks the limits which cost a system call and prints the progress.
+ *  Called once per poll_interval propagations, so that the clock is not
+ *  read in the hot loop. False when a limit is reached. */
+bool solver::poll()
+{
+    next_poll = stats.propagations + poll_interval;
+    if ( limits.propagations > 0 )
+    {
+        if ( stats.propagations >= limits.propagations )
+        {
+            limit_reached = true;
+            return false;
+        }
+        next_poll = std::min( next_poll, limits.propagations );
+    }
+
+    if ( report_interval <= 0 && limits.seconds <= 0 && limits.memory_mb == 0 )
+        return true;
+
+    double now = seconds_since( start_time );
+    if ( report_interval > 0 && now >= next_report )
+        report( now );
+
+    if ( ( limits.seconds > 0 && now >= limits.seconds )
+      || ( limits.memory_mb > 0 && peak_memory_mb() >= limits.memory_mb ) )
+        limit_reached = true;
+    return ! limit_reached;
+}
+
+
+/** Prints a progress line, the rates are those since the previous one. */
+void solver::report( double now )
+{
+    next_report = now + report_interval;
+
+    if ( reports++ % 20 == 0 )
+        printf( "c %9s %10s %8s %8s %8s %8s %8s %10s %10s\n", "seconds", "conflicts"
+              , "restarts", "learnt", "original", "binary", "fixed", "confl/s", "props/s" );
+
+    double elapsed = now - reported_seconds;
+    size_t fixed = decisions.empty() ? trail.size() : decisions[ 0 ];
+    printf( "c %9.2f %10zu %8zu %8zu %8zu %8zu %8zu %10.0f %10.0f\n", now, stats.conflicts
+          , stats.restarts, clauses.learnt_count, clauses.count - clauses.learnt_count
+          , binary_count(), fixed
+          , ( stats.conflicts - reported_conflicts ) / elapsed
+          , ( stats.propagations - reported_propagations ) / elapsed );
+    fflush( stdout );
+
+    reported_seconds = now;
+    reported_conflicts = stats.conflicts;
+    reported_propagations = stats.propagations;
+}
+
+
+size_t solver::binary_count() const
+{
+    size_t count = 0;
+    for ( const auto &others : binary_in.content )
+        count += others.size();
+    return count / 2 + ( formula_binaries ? formula_binaries->count() : 0 );
+}
+
+
+/// Picking literal ////////////////////////////////////////////////////////////
 
 
 lit_t solver::pick_literal()
 {
+    if ( use_queue() )
+    {
+        var_t v = queue.next( [&]( var_t u ) { return values[ u ] != val_un; } );
+
+        #ifdef CHECKED
+        for ( var_t u = 1; u <= var_count; u++ )
+            assert( values[ u ] != val_un || ( v != 0 && queue.stamp[ u ] <= queue.stamp[ v ] ) );
+        #endif
+
+        if ( v == 0 )
+            return 0;
+        return decision_literal( v );
+    }
+
     while ( heap.size > 0 )
     {
         var_t v = heap.extract_max();
         if ( values[ v ] == val_un )
-            return - v;
+            return decision_literal( v );
     }
     return 0;
 }
 
 
-/// Values ////////////////////////////////////////////////////////////////////
+/// Phases /////////////////////////////////////////////////////////////////////
+
+
+lit_t solver::decision_literal( var_t v )
+{
+    val_t phase = phases[ v ];
+    if ( ( target_mode == 2 || ( target_mode == 1 && restarts.stable ) )
+         && target_phases[ v ] != val_un )
+        phase = target_phases[ v ];
+    return phase == val_tt ? lit_t( v ) : - lit_t( v );
+}
+
+
+/** Called on a conflict. The trail below the conflict level has no
+ *  conflict, its values become the target phases when it is the longest
+ *  since the last restart, and the best phases when it is the longest
+ *  since they were last used. */
+void solver::update_phases()
+{
+    size_t assigned = decisions.back();
+    auto save = [&]( std::vector< val_t > &to ) {
+        for ( size_t i = 0; i < assigned; i++ )
+            to[ var_of_lit( trail[ i ] ) ] = val_of_lit( trail[ i ] );
+    };
+
+    if ( target_mode > 0 && assigned > target_assigned )
+    {
+        save( target_phases );
+        target_assigned = assigned;
+    }
+    if ( rephase_interval > 0 && assigned > best_assigned )
+    {
+        save( best_phases );
+        best_assigned = assigned;
+    }
+}
+
+
+enum rephase_t
+{
+    ORIGINAL, INVERTED, BEST, RANDOM, WALK
+};
+
+/** Resets the saved phases, and the target ones with them: to the initial
+ *  phases, their inversion, the best phases, random ones or those a local
+ *  search finds. After the first two, the best phases come every other
+ *  time, or every third with the local search. */
+void solver::rephase()
+{
+    static const rephase_t first[] = { ORIGINAL, INVERTED };
+    static const rephase_t cycle[] = { BEST, ORIGINAL, BEST, INVERTED, BEST, RANDOM };
+    static const rephase_t walk_cycle[] = { BEST, WALK, ORIGINAL, BEST, WALK, INVERTED, BEST, RANDOM };
+
+    size_t n = stats.rephases++;
+    rephase_t kind = n < 2 ? first[ n ]
+                   : walk_effort > 0 ? walk_cycle[ ( n - 2 ) % 8 ]
+                   : cycle[ ( n - 2 ) % 6 ];
+    next_rephase = stats.conflicts + rephase_interval * stats.rephases;
+
+    if ( kind == WALK )
+        walk();
+
+    val_t original = phases[ 0 ];
+    auto random_phase = [&]() { return phase_random() & 1 ? val_tt : val_ff; };
+    for ( var_t v = 1; v <= var_count && kind != WALK; v++ )
+    {
+        if ( kind == BEST && best_phases[ v ] != val_un )
+            phases[ v ] = best_phases[ v ];
+        else if ( kind == RANDOM || ( kind != BEST && original == val_un ) )
+            phases[ v ] = random_phase();
+        else if ( kind == ORIGINAL )
+            phases[ v ] = original;
+        else if ( kind == INVERTED )
+            phases[ v ] = original == val_tt ? val_ff : val_tt;
+    }
+
+    if ( kind == BEST )
+        best_assigned = 0;
+    target_phases = phases;
+    target_assigned = 0;
+}
+
+
+/** Local search from the saved phases on the irredundant clauses reduced
+ *  by the level 0 values, its best assignment becomes the saved phases.
+ *  The flips get a share of the propagation work done by the search since
+ *  the previous walk. */
+void solver::walk()
+{
+    scoped_timer t( timer( LOCAL_SEARCH ) );
+    ++stats.walks;
+    backtrack( 0 );
+
+    cnf_t cnf;
+    cnf.var_count = var_count;
+    clause_t reduced;
+    bool satisfied = false;
+    auto push = [&]( lit_t l ) {
+        val_t v = eval_lit( l );
+        satisfied |= v == val_tt;
+        if ( v == val_un )
+            reduced.push_back( l );
+    };
+    auto flush = [&]() {
+        if ( ! satisfied )
+            cnf.add_clause( reduced );
+        reduced.clear();
+        satisfied = false;
+    };
+
+    for ( cref_t c = clauses.begin(); c != clauses.end(); c = clauses.next( c ) )
+    {
+        if ( clauses.deleted( c ) || clauses.learnt( c ) )
+            continue;
+        for ( size_t i = 0; i < clauses.size( c ); i++ )
+            push( clauses( c, i ) );
+        flush();
+    }
+
+    for ( lit_t a = - lit_t( var_count ); a <= lit_t( var_count ); a++ )
+        for ( idx_t i = 0; i < implied_count( a ); i++ )
+            if ( lit_t b = implied( a, i ); a < b )
+            {
+                push( a );
+                push( b );
+                flush();
+            }
+
+    // A flip visits the occurrences of both literals of its variable, each
+    // about as costly as a watcher visit.
+    double flip_ticks = 1.0 + double( cnf.literals.size() ) / std::max< size_t >( 1, var_count );
+    size_t budget = std::max< size_t >( 10000, walk_effort * ( ticks() - walk_ticks ) / flip_ticks );
+    walk_ticks = ticks();
+
+    sls_config config;
+    config.seed = phase_random();
+    config.max_flips = budget;
+    local_search ls( cnf, config );
+    ls.stop = stop;
+    ls.assign( phases );
+    ls.walk();
+
+    std::vector< val_t > best = ls.best_values();
+    for ( var_t v = 1; v <= var_count; v++ )
+        if ( values[ v ] == val_un )
+            phases[ v ] = best[ v ];
+
+    stats.walk_flips += ls.stats.flips;
+    stats.walk_seconds += ls.stats.seconds;
+}
+
+
+/// Values /////////////////////////////////////////////////////////////////////
 
 
 val_t solver::eval_lit( lit_t l )
@@ -129,40 +748,83 @@ val_t solver::eval_lit( lit_t l )
 }
 
 
-/// Backtracking //////////////////////////////////////////////////////////////
+/// Backtracking ///////////////////////////////////////////////////////////////
 
 
-sidx_t solver::decide( lit_t l )
+void solver::decide( lit_t l )
 {
+    ++stats.decisions;
     decisions.push_back( trail.size() );
     decision_level += 1;
-    return assign( phases[ var_of_lit( l ) ] == val_tt ? l : -l );
+    assign( l, reason_t() );
 }
 
 
-sidx_t solver::assign( lit_t l )
+/** Assigns l at the given level and puts it on the trail, its
+ *  consequences are found later by unit_propagation. Only assignments
+ *  implied by a clause count as propagations. */
+void solver::assign( lit_t l, reason_t why, sidx_t level )
 {
-    logger.log( "assign", "%d@%d", l, decision_level );
+    logger.log( "assign", "%d@%d", l, level );
+    assert( eval_lit( l ) == val_un );
+    assert( level <= decision_level );
+    if ( ! why.empty() )
+        ++stats.propagations;
     values[ var_of_lit( l ) ] = val_of_lit( l );
     phases[ var_of_lit( l ) ] = l > 0 ? val_tt : val_ff;
     trail.push_back( l );
-    lit_level[ l ] = decision_level;
-    return update_watches( l );
+    lit_level[ l ] = level;
+    reason[ l ] = why;
+
+    if ( level == 0 && lrat && ! why.empty() )
+        derive_unit( l, why );
 }
 
 
+/** The highest level of the other literals of the reason of l. */
+sidx_t solver::reason_level( lit_t l, reason_t why )
+{
+    if ( why.clause == idx_undef )
+        return lit_level[ - why.binary ];
+
+    sidx_t level = 0;
+    for ( size_t i_l = 0; i_l < clauses.size( why.clause ); i_l++ )
+    {
+        lit_t r = clauses( why.clause, i_l );
+        if ( r != l )
+            level = std::max( level, lit_level[ -r ] );
+    }
+    return level;
+}
+
+
+/** Unassigns the literals from trail position i on whose level is above
+ *  the current one. The others, implied at a lower level after a
+ *  chronological backtrack, stay in their order and are propagated
+ *  again. */
 void solver::kill_trail( idx_t i )
 {
-    // Assignments above decision.
+    idx_t kept = i;
     for ( idx_t j = i; j < trail.size(); j++ )
     {
-        auto &t_j = trail[ j ];
+        lit_t t_j = trail[ j ];
+        if ( lit_level[ t_j ] <= decision_level )
+        {
+            trail[ kept++ ] = t_j;
+            continue;
+        }
+
         values[ var_of_lit( t_j ) ] = val_un;
-        reason[ t_j ] = idx_undef;
-        heap.push( var_of_lit( t_j ) );
+        reason[ t_j ] = reason_t();
+        if ( keep_heap() )
+            heap.push( var_of_lit( t_j ) );
+        if ( keep_queue() )
+            queue.unassign( var_of_lit( t_j ) );
         lit_level[ t_j ] = -1;
     }
-    trail.resize( i );
+    trail.resize( kept );
+    qhead = std::min( qhead, i );
+    bin_qhead = std::min( bin_qhead, i );
 }
 
 
@@ -172,176 +834,225 @@ void solver::backtrack( sidx_t target_level )
 
     log_trail( "b", *this );
 
+    if ( decision_level <= target_level )
+        return;
 
-    idx_t last_dec = decisions.back();
-    while ( decision_level > target_level )
-    {
-        last_dec = decisions.back();
-        decisions.pop_back();
-        decision_level--;
-    }
+    idx_t last_dec = decisions[ target_level ];
+    decisions.resize( target_level );
+    decision_level = target_level;
 
     kill_trail( last_dec );
 }
 
 
-/// Unit propagation //////////////////////////////////////////////////////////
+/// Unit propagation ///////////////////////////////////////////////////////////
 
 
-/** Solver assigned l */
-sidx_t solver::update_watches( lit_t l )
+/** Assigns the literals b of the binary clauses ( -l, b ) in others. */
+template < typename lits_t >
+sidx_t solver::propagate_implied( lit_t l, const lits_t &others )
 {
-    idx_t i_w_l = 0;
+    for ( lit_t b : others )
+    {
+        val_t v = eval_lit( b );
+        if ( v == val_ff )
+        {
+            binary_conflict = { -l, b };
+            return idx_binary;
+        }
+        if ( v == val_un )
+        {
+            ++stats.binary_propagations;
+            assign( b, { idx_undef, -l }, lit_level[ l ] );
+        }
+    }
+    return idx_undef;
+}
 
-    auto &w_l = watched_in[ -l ];
 
-    while ( i_w_l < w_l.size() )
+/** Assigns the literals implied by l through binary clauses. */
+sidx_t solver::propagate_binary( lit_t l )
+{
+    if ( formula_binaries )
     {
-        idx_t i_c = w_l[ i_w_l ];
+        sidx_t i_c = propagate_implied( l, ( *formula_binaries )[ -l ] );
+        if ( i_c != idx_undef )
+            return i_c;
+    }
+    return propagate_implied( l, binary_in[ -l ] );
+}
+
+
+/** Visits the long clauses watching -l, after l was assigned. */
+sidx_t solver::update_watches( lit_t l )
+{
+    auto &w_l = watched_in[ -l ];
 
-        assert( clauses.size( i_c ) > 1 );
+    idx_t i = 0;
+    idx_t j = 0;
+    while ( i < w_l.size() )
+    {
+        ++stats.watcher_visits;
 
-        // If the clause is unit
+        // A true blocker satisfies the clause, no need to look at it.
 
-        if ( eval_lit( clauses( i_c, 0 ) ) == val_ff
-          && eval_lit( clauses( i_c, 1 ) ) == val_ff )
+        if ( eval_lit( w_l[ i ].blocker ) == val_tt )
         {
-#ifdef CHECKED
-            for ( size_t i = 0; i < clauses.size( i_c ); ++i )
-                assert( eval_lit( clauses( i_c, i ) ) == val_ff );
-#endif
-            return i_c;
+            ++stats.blocker_hits;
+            w_l[ j++ ] = w_l[ i++ ];
+            continue;
         }
 
+        cref_t i_c = w_l[ i ].clause;
+        lit_t *c = clauses.watched( i_c );
+        size_t c_size = clauses.size( i_c );
+        i++;
 
-        // wlog: l is in the 1 position.
-
-        if ( clauses( i_c, 0 ) == -l )
-            std::swap( clauses( i_c, 0 ), clauses( i_c, 1 ) );
+        assert( c_size > 1 );
 
-        assert( -l == clauses( i_c, 1 ) );
+        // wlog: -l is in the 1 position.
 
-        /** State: c[0] != false, c[1] = false */
+        if ( c[ 0 ] == -l )
+            std::swap( c[ 0 ], c[ 1 ] );
 
-        #ifdef CHECKED
-        assert( eval_lit( clauses( i_c, 0 ) ) != val_ff );
-        assert( eval_lit( clauses( i_c, 1 ) ) == val_ff );
-        #endif
+        assert( -l == c[ 1 ] );
 
         // Check if first is solved
 
-        if ( eval_lit( clauses( i_c, 0 ) ) == val_tt ) {
-            i_w_l++;
+        watcher w = { i_c, c[ 0 ] };
+        val_t v_0 = eval_lit( c[ 0 ] );
+        if ( v_0 == val_tt )
+        {
+            w_l[ j++ ] = w;
             continue;
         }
 
-        /** State: c[0] = unk, c[1] = false */
-
-        #ifdef CHECKED
-        assert( eval_lit( clauses( i_c, 0 ) ) == val_un );
-        assert( eval_lit( clauses( i_c, 1 ) ) == val_ff );
-        #endif
+        // Look for a new literal to watch.
 
         bool found = false;
-        for ( idx_t i_l = 2; i_l < clauses.size( i_c ); i_l++ )
+        if ( ! clauses.shared( i_c ) )
         {
-            val_t v = eval_lit( clauses( i_c, i_l ) );
-            if ( v == val_tt || v == val_un ) {
-
-                watched_in[ clauses( i_c, i_l ) ].push_back( i_c );
-
-                std::swap( w_l[ i_w_l ], w_l.back() );
-                w_l.pop_back();
-
-                std::swap( clauses( i_c, i_l ), clauses( i_c, 1 ) );
-                if ( v == val_tt ) {
-                    // This swap is so that watched_in[ c[ 0 ] ] is
-                    // the list through which we are iterating so
-                    // that we can kick the clause in the current list.
-                    std::swap( clauses( i_c, 0 ), clauses( i_c, 1 ) );
+            for ( idx_t i_l = 2; i_l < c_size; i_l++ )
+            {
+                if ( eval_lit( c[ i_l ] ) != val_ff )
+                {
+                    std::swap( c[ i_l ], c[ 1 ] );
+                    watched_in[ c[ 1 ] ].push_back( w );
+                    found = true;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            // The watched literals of a shared clause are somewhere among
+            // its literals.
+            const lit_t *all = clauses.lits( i_c );
+            for ( idx_t i_l = 0; i_l < c_size; i_l++ )
+            {
+                lit_t q = all[ i_l ];
+                if ( q != c[ 0 ] && q != c[ 1 ] && eval_lit( q ) != val_ff )
+                {
+                    c[ 1 ] = q;
+                    watched_in[ q ].push_back( w );
+                    found = true;
+                    break;
                 }
-                found = true;
-                break;
             }
         }
 
-        if ( ! found )
+        if ( found )
+            continue;
+
+        // Condition: c[1:] = false
+
+        w_l[ j++ ] = w;
+
+        if ( v_0 == val_ff )
         {
-            // Condition: c[0] = unk; c[1:] = false;
             #ifdef CHECKED
-            assert( eval_lit( clauses( i_c, 0 ) ) == val_un );
-            for ( idx_t i = 1; i < clauses.size( i_c ); i++ )
+            for ( size_t i = 0; i < c_size; ++i )
                 assert( eval_lit( clauses( i_c, i ) ) == val_ff );
             #endif
-            logger.log( "unitprop", "%d", i_c );
-            unit_queue.push_back( i_c );
-            i_w_l++;
+
+            while ( i < w_l.size() )
+                w_l[ j++ ] = w_l[ i++ ];
+            w_l.resize( j );
+            return i_c;
         }
-        // Else: c[0] = true or c[0] = unk, c[1] = unk
+
+        // Below the current level, the other false literals may come from
+        // a higher one.
+        logger.log( "unitprop", "%d", i_c );
+        reason_t why = { sidx_t( i_c ), 0 };
+        sidx_t level = lit_level[ l ];
+        assign( c[ 0 ], why, level < decision_level ? reason_level( c[ 0 ], why ) : level );
     }
 
+    w_l.resize( j );
     return idx_undef;
 }
 
 
+/** Propagates the assignments on the trail from qhead on, binary clauses
+ *  of all of them before the long ones. */
 sidx_t solver::unit_propagation()
 {
-    while ( ! unit_queue.empty() )
+    while ( qhead < trail.size() )
     {
-        //logger.log( "unit queue", unit_queue );
-        //logger.log( "unit trail", trail );
-        //logger.log( "unit decs", decisions );
-        idx_t i_c = unit_queue.front();
-        unit_queue.pop_front();
-
-        // Condition: all except first literal are false
-
-        #ifdef CHECKED
-        for ( idx_t i = 1; i < clauses.size( i_c ); i++ )
+        while ( bin_qhead < trail.size() )
         {
-            if ( eval_lit( clauses( i_c, i ) ) != val_ff )
+            if ( sidx_t i_c = propagate_binary( trail[ bin_qhead++ ] ); i_c != idx_undef )
             {
-                // logger.log( "PROBLEM", c );
-                for ( size_t i = 0; i < clauses.size( i_c ); ++i )
-                {
-                    lit_t l = clauses( i_c, i );
-                    logger.log( "PROBLEM", "%d@%d -> %f", -l, lit_level[ -l ], eval_lit( l ) );
-                }
+                qhead = bin_qhead = trail.size();
+                return i_c;
             }
-            assert( eval_lit( clauses( i_c, i) ) == val_ff );
         }
-        #endif
-
-        // First is false
-        val_t v = eval_lit( clauses( i_c, 0 ) );
-
-        //logger.log( "lol", "%d, %d = %d", c[ 0 ], c[ 1 ], v );
 
-        if ( v == val_tt )
-            continue;
-        else if ( v == val_ff )
-            return i_c;
-        else if ( v == val_un )
+        if ( sidx_t i_c = update_watches( trail[ qhead++ ] ); i_c != idx_undef )
         {
-            assert( reason[ clauses( i_c, 0 ) ] == idx_undef );
-            reason[ clauses( i_c, 0 ) ] = i_c;
-
-            if ( sidx_t a_i = assign( clauses( i_c, 0 ) ); a_i != idx_undef )
-                return a_i;
+            qhead = bin_qhead = trail.size();
+            return i_c;
         }
     }
     return idx_undef;
 }
 
 
-/// CDCL //////////////////////////////////////////////////////////////////////
+/// CDCL ///////////////////////////////////////////////////////////////////////
+
+
+void solver::resolve_lit( clause_t& learnt_clause, lit_t l )
+{
+    // Literals false at level 0 are false for good.
+    if ( lit_level[ -l ] == 0 )
+        return;
+
+    if ( lit_level[ -l ] == decision_level )
+        to_resolve.add( -l );
+    else
+    {
+        if ( ! learnt_lit.contains( l ) )
+            learnt_clause.push_back( l );
+        learnt_lit.add( l );
+    }
+}
 
 
-void solver::resolve_part( clause_t& learnt_clause, idx_t i_c, lit_t r )
+void solver::resolve_part( clause_t& learnt_clause, reason_t r_c, lit_t r )
 {
     if ( r != 0 )
         to_resolve.remove( r );
 
+    if ( r_c.clause == idx_undef )
+    {
+        assert( r_c.binary != 0 );
+        resolve_lit( learnt_clause, r_c.binary );
+        return;
+    }
+
+    cref_t i_c = r_c.clause;
+
     #ifdef CHECKED
         bool found = false;
         for ( size_t i = 0; i < clauses.size( i_c ); ++i )
@@ -349,29 +1060,113 @@ void solver::resolve_part( clause_t& learnt_clause, idx_t i_c, lit_t r )
         assert( found || r == 0 );
     #endif
 
-    for ( size_t i_l = 0; i_l < clauses.size( i_c ); ++i_l )
+    if ( clauses.learnt( i_c ) )
     {
-        lit_t l = clauses( i_c, i_l );
-        if ( l == r ) continue;
-
-        if ( lit_level[ -l ] == decision_level )
-            to_resolve.add( -l );
-        else
+        bump_clause( i_c );
+        if ( clauses.lbd( i_c ) > 2 )
         {
-            if ( ! learnt_lit.contains( l ) )
-                learnt_clause.push_back( l );
-            learnt_lit.add( l );
+            unsigned int lbd = compute_lbd( i_c );
+            if ( lbd < clauses.lbd( i_c ) )
+                clauses.set_lbd( i_c, lbd );
         }
     }
-}
-
+
+    for ( size_t i_l = 0; i_l < clauses.size( i_c ); ++i_l )
+    {
+        lit_t l = clauses( i_c, i_l );
+        if ( l == r ) continue;
+
+        resolve_lit( learnt_clause, l );
+    }
+}
+
+
+/** The highest level of the literals of the conflict i_c, which is below
+ *  the current one when they were implied at lower levels. forced is set
+ *  to the only literal at that level, if there is one. The literals of
+ *  the two highest levels become the watched ones, as they are the first
+ *  to be unassigned. */
+sidx_t solver::conflict_level( sidx_t i_c, lit_t &forced )
+{
+    forced = 0;
+    if ( i_c == idx_binary )
+    {
+        auto [ a, b ] = binary_conflict;
+        if ( lit_level[ -a ] != lit_level[ -b ] )
+            forced = lit_level[ -a ] > lit_level[ -b ] ? a : b;
+        return std::max( lit_level[ -a ], lit_level[ -b ] );
+    }
+
+    lit_t *c = clauses.watched( i_c );
+    lit_t first = c[ 0 ];
+    lit_t second = c[ 1 ];
+    if ( lit_level[ -second ] > lit_level[ -first ] )
+        std::swap( first, second );
+
+    const lit_t *all = clauses.lits( i_c );
+    for ( size_t i_l = 0; i_l < clauses.size( i_c ); i_l++ )
+    {
+        lit_t q = all[ i_l ];
+        if ( q == c[ 0 ] || q == c[ 1 ] )
+            continue;
+        if ( lit_level[ -q ] > lit_level[ -first ] )
+        {
+            second = first;
+            first = q;
+        }
+        else if ( lit_level[ -q ] > lit_level[ -second ] )
+            second = q;
+    }
+
+    for ( lit_t q : { first, second } )
+    {
+        if ( q == c[ 0 ] || q == c[ 1 ] )
+            continue;
+        lit_t replaced = c[ 0 ] != first && c[ 0 ] != second ? c[ 0 ] : c[ 1 ];
+        rewatch( i_c, replaced, q );
+    }
+    if ( c[ 0 ] != first )
+        std::swap( c[ 0 ], c[ 1 ] );
+
+    if ( lit_level[ -second ] < lit_level[ -first ] )
+        forced = first;
+    return lit_level[ -first ];
+}
+
+
+/** Makes the clause i_c watch the literal to instead of from. */
+void solver::rewatch( cref_t i_c, lit_t from, lit_t to )
+{
+    auto &w_from = watched_in[ from ];
+    auto w = std::find_if( w_from.begin(), w_from.end(), [&]( const watcher &x ) {
+        return x.clause == i_c;
+    } );
+    assert( w != w_from.end() );
+    w_from.erase( w );
+
+    lit_t *c = clauses.watched( i_c );
+    lit_t &slot = c[ 0 ] == from ? c[ 0 ] : c[ 1 ];
+    if ( clauses.shared( i_c ) )
+        slot = to;
+    else
+        std::swap( slot, *std::find( c + 2, c + clauses.size( i_c ), to ) );
+
+    watched_in[ to ].push_back( { i_c, c[ 0 ] == to ? c[ 1 ] : c[ 0 ] } );
+}
+
 
 std::pair< clause_t, idx_t > solver::conflict_anal( sidx_t i_c )
 {
     idx_t last_d_i = decisions.back();
 
     clause_t learnt_clause;
-    resolve_part( learnt_clause, i_c, 0 );
+    if ( i_c == idx_binary )
+    {
+        resolve_lit( learnt_clause, binary_conflict.first );
+        resolve_lit( learnt_clause, binary_conflict.second );
+    }
+    else
+        resolve_part( learnt_clause, { i_c, 0 }, 0 );
 
     #ifdef CHECKED
     bool found = false;
@@ -392,7 +1187,7 @@ std::pair< clause_t, idx_t > solver::conflict_anal( sidx_t i_c )
         auto &t_j = trail[ j ];
         if ( to_resolve.contains( t_j ) )
         {
-            assert( reason[ t_j ] != idx_undef );
+            assert( ! reason[ t_j ].empty() );
             resolve_part( learnt_clause, reason[ t_j ], t_j );
             bump( var_of_lit( t_j ) );
         }
@@ -409,6 +1204,12 @@ std::pair< clause_t, idx_t > solver::conflict_anal( sidx_t i_c )
     for ( auto l : learnt_clause )
         bump( var_of_lit( l ) );
     increase_bump();
+    bump_queue();
+
+    minimize( learnt_clause );
+
+    if ( lrat )
+        collect_hints( learnt_clause, i_c );
 
     /** Find the next dec level to which we are jumping. The level
      *  has to be witnessed by some literal. The literal will
@@ -476,52 +1277,1442 @@ std::pair< clause_t, idx_t > solver::conflict_anal( sidx_t i_c )
 }
 
 
-idx_t solver::learn( clause_t c )
+/** Removes the literals of the learnt clause which are implied by the
+ *  others through their reasons. */
+void solver::minimize( clause_t& learnt_clause )
+{
+    size_t before = learnt_clause.size();
+
+    uint32_t levels = 0;
+    for ( idx_t i_l = 1; i_l < learnt_clause.size(); i_l++ )
+        levels |= abstract_level( lit_level[ - learnt_clause[ i_l ] ] );
+
+    minimize_clear.clear();
+
+    idx_t j = 1;
+    for ( idx_t i_l = 1; i_l < learnt_clause.size(); i_l++ )
+    {
+        lit_t l = learnt_clause[ i_l ];
+        if ( reason[ -l ].empty() || ! lit_redundant( l, levels ) )
+            learnt_clause[ j++ ] = l;
+        else
+            minimize_clear.push_back( l );
+    }
+    learnt_clause.resize( j );
+
+    // The removed literals and the ones found redundant on the way stayed
+    // in learnt_lit so that they could be used by the others.
+    for ( lit_t l : minimize_clear )
+        learnt_lit.remove( l );
+
+    stats.minimized_literals += before - learnt_clause.size();
+    stats.learnt_literals += learnt_clause.size();
+}
+
+
+/** Checks whether the false literal l is implied by the literals in
+ *  learnt_lit. The search gives up on decisions and on literals from
+ *  levels which are not in the clause at all ( using the abstraction of
+ *  the levels to a bitmask ). Literals found redundant are added to
+ *  learnt_lit and to minimize_clear. */
+bool solver::lit_redundant( lit_t l, uint32_t levels )
+{
+    size_t top = minimize_clear.size();
+    minimize_stack.clear();
+    minimize_stack.push_back( l );
+
+    while ( ! minimize_stack.empty() )
+    {
+        lit_t q = minimize_stack.back();
+        minimize_stack.pop_back();
+
+        bool ok = true;
+        auto visit = [&]( lit_t r ) {
+            if ( learnt_lit.contains( r ) || lit_level[ -r ] == 0 )
+                return;
+
+            if ( ! reason[ -r ].empty()
+              && ( abstract_level( lit_level[ -r ] ) & levels ) != 0 )
+            {
+                learnt_lit.add( r );
+                minimize_stack.push_back( r );
+                minimize_clear.push_back( r );
+            }
+            else
+                ok = false;
+        };
+
+        reason_t why = reason[ -q ];
+        if ( why.clause == idx_undef )
+            visit( why.binary );
+        else
+        {
+            for ( size_t i_l = 0; ok && i_l < clauses.size( why.clause ); i_l++ )
+                if ( clauses( why.clause, i_l ) != -q )
+                    visit( clauses( why.clause, i_l ) );
+        }
+
+        if ( ! ok )
+        {
+            for ( idx_t i = top; i < minimize_clear.size(); i++ )
+                learnt_lit.remove( minimize_clear[ i ] );
+            minimize_clear.resize( top );
+            return false;
+        }
+    }
+    return true;
+}
+
+
+reason_t solver::learn( clause_t c )
 {
     logger.log( "learn", c );
 
     //log_trail( "l", *this );
 
-    idx_t i = clauses.count;
-    clauses.add( c );
-
     assert( ! c.empty() );
-    watched_in[ c[ 0 ] ].push_back( i );
-    if ( c.size() > 1 )
-        watched_in[ c[ 1 ] ].push_back( i );
 
-    return i;
+    uint64_t id = 0;
+    if ( proof )
+        id = proof->add( c, hints );
+
+    // Units are asserted at level 0 and never undone, they need no clause.
+    learnt_lbd = std::min< size_t >( c.size(), 2 );
+    if ( c.size() == 1 )
+    {
+        if ( lrat )
+            unit_id[ var_of_lit( c[ 0 ] ) ] = id;
+        if ( share )
+            export_clause( c, 1 );
+        return reason_t();
+    }
+
+    if ( c.size() == 2 )
+    {
+        add_binary( c[ 0 ], c[ 1 ], id );
+        if ( share )
+            export_clause( c, 2 );
+        return { idx_undef, c[ 1 ] };
+    }
+
+    unsigned int lbd = compute_lbd( c );
+    learnt_lbd = lbd;
+    if ( share )
+        export_clause( c, lbd );
+
+    cref_t i = clauses.add( c, true, lbd );
+    if ( lrat )
+        clauses.set_id( i, id );
+    bump_clause( i );
+    attach( i );
+
+    return { sidx_t( i ), 0 };
+}
+
+
+void solver::add_binary( lit_t a, lit_t b, uint64_t id )
+{
+    binary_in[ a ].push_back( b );
+    binary_in[ b ].push_back( a );
+
+    if ( lrat )
+    {
+        binary_ids[ a ].push_back( id );
+        binary_ids[ b ].push_back( id );
+    }
+}
+
+
+/** Copies the shared binary clauses of the formula to binary_in, before
+ *  they are rewritten or the variables outgrow them. */
+void solver::own_binaries()
+{
+    if ( ! formula_binaries )
+        return;
+
+    lit_t n = formula_binaries->var_count;
+    for ( lit_t a = -n; a <= n; a++ )
+    {
+        clause_view shared = ( *formula_binaries )[ a ];
+        binary_in[ a ].insert( binary_in[ a ].begin(), shared.begin(), shared.end() );
+    }
+    formula_binaries = nullptr;
+}
+
+
+binary_lists::binary_lists( const cnf_t &cnf )
+    : var_count( cnf.var_count )
+    , start( 2 * size_t( cnf.var_count ) + 2, 0 )
+{
+    auto binary = [&]( size_t i ) {
+        clause_view c = cnf.clause( i );
+        return c.size() == 2 && c[ 0 ] != -c[ 1 ];
+    };
+
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+        if ( binary( i ) )
+            for ( lit_t l : cnf.clause( i ) )
+                ++start[ l + var_count + 1 ];
+    for ( size_t i = 1; i < start.size(); i++ )
+        start[ i ] += start[ i - 1 ];
+
+    // Each list in the order of the clauses, as add_binary would.
+    lits.resize( start.back() );
+    std::vector< size_t > end( start.begin(), start.end() - 1 );
+    for ( size_t i = 0; i < cnf.clause_count(); i++ )
+        if ( binary( i ) )
+        {
+            clause_view c = cnf.clause( i );
+            lits[ end[ c[ 0 ] + var_count ]++ ] = c[ 1 ];
+            lits[ end[ c[ 1 ] + var_count ]++ ] = c[ 0 ];
+        }
+}
+
+
+/// Learnt clause database /////////////////////////////////////////////////////
+
+
+/** Literal block distance: the number of distinct decision levels among
+ *  the literals of the clause. Has to be called while the literals are
+ *  still assigned. */
+unsigned int solver::compute_lbd( cref_t i_c )
+{
+    ++lbd_stamp;
+    unsigned int lbd = 0;
+    for ( size_t i_l = 0; i_l < clauses.size( i_c ); i_l++ )
+    {
+        sidx_t level = lit_level[ - clauses( i_c, i_l ) ];
+        if ( level >= 0 && level_stamp[ level ] != lbd_stamp )
+        {
+            level_stamp[ level ] = lbd_stamp;
+            ++lbd;
+        }
+    }
+    return lbd;
+}
+
+
+unsigned int solver::compute_lbd( const clause_t &c )
+{
+    ++lbd_stamp;
+    unsigned int lbd = 0;
+    for ( lit_t l : c )
+    {
+        sidx_t level = lit_level[ -l ];
+        if ( level >= 0 && level_stamp[ level ] != lbd_stamp )
+        {
+            level_stamp[ level ] = lbd_stamp;
+            ++lbd;
+        }
+    }
+    return lbd;
+}
+
+
+void solver::bump_clause( cref_t i_c )
+{
+    clauses.set_activity( i_c, clauses.activity( i_c ) + clause_bump_size );
+
+    double max_bump = 1e20;
+    if ( clauses.activity( i_c ) > max_bump )
+    {
+        for ( cref_t i = clauses.begin(); i != clauses.end(); i = clauses.next( i ) )
+            if ( clauses.learnt( i ) )
+                clauses.set_activity( i, clauses.activity( i ) / max_bump );
+        clause_bump_size /= max_bump;
+    }
+}
+
+
+/** Deletes the worse half of the learnt clauses and moves the remaining
+ *  ones to a fresh arena. Clauses with lbd <= 2 and reasons of the current
+ *  assignment are kept. Has to be called with everything propagated. */
+void solver::reduce_db()
+{
+    assert( qhead == trail.size() );
+    scoped_timer t( timer( REDUCTION ) );
+
+    ++reduce_count;
+    ++stats.reductions;
+    next_reduce = total_conflicts + 2000 + 300 * reduce_count;
+
+    literal_set locked_by( var_count );
+    for ( lit_t l : trail )
+        if ( reason[ l ].clause != idx_undef )
+            locked_by.add( l );
+
+    auto locked = [&]( cref_t i_c ) {
+        lit_t l = clauses( i_c, 0 );
+        return locked_by.contains( l ) && reason[ l ].clause == sidx_t( i_c );
+    };
+
+    std::vector< cref_t > candidates;
+    for ( cref_t i_c = clauses.begin(); i_c != clauses.end(); i_c = clauses.next( i_c ) )
+        if ( clauses.learnt( i_c ) && ! clauses.deleted( i_c )
+          && clauses.lbd( i_c ) > 2 && clauses.size( i_c ) > 2 && ! locked( i_c ) )
+            candidates.push_back( i_c );
+
+    // Worst first: high lbd, then low activity.
+    std::sort( candidates.begin(), candidates.end(), [&]( cref_t a, cref_t b ) {
+        if ( clauses.lbd( a ) != clauses.lbd( b ) )
+            return clauses.lbd( a ) > clauses.lbd( b );
+        return clauses.activity( a ) < clauses.activity( b );
+    } );
+
+    for ( idx_t i = 0; i < candidates.size() / 2; i++ )
+    {
+        cref_t i_c = candidates[ i ];
+        if ( proof )
+            proof->remove( lrat ? clauses.id( i_c ) : 0, clauses.lits( i_c )
+                         , clauses.lits( i_c ) + clauses.size( i_c ) );
+        clauses.remove( i_c );
+    }
+
+    logger.log( "reduce", "%d", candidates.size() / 2 );
+
+    collect_garbage();
+}
+
+
+/** Relocates the clauses into a new arena without the deleted ones and
+ *  translates the references in watch lists and reasons. */
+void solver::collect_garbage()
+{
+    clause_arena to;
+    clauses.move_to( to );
+
+    for ( auto &w : watched_in.content )
+    {
+        idx_t j = 0;
+        for ( watcher wa : w )
+            if ( ! clauses.deleted( wa.clause ) )
+                w[ j++ ] = { clauses.forward( wa.clause ), wa.blocker };
+        w.resize( j );
+    }
+
+    for ( lit_t l : trail )
+        if ( reason[ l ].clause != idx_undef )
+            reason[ l ].clause = clauses.forward( reason[ l ].clause );
+
+    clauses = std::move( to );
 }
 
+
 // EVSIDS
 
 void solver::increase_bump()
 {
     bump_size *= bump_step;
+    clause_bump_size *= clause_bump_step;
 
-    double max_bump = 42069420.1337;
-    if ( bump_size > max_bump )
+    if ( bump_size > var_heap::max_score )
     {
-        for ( size_t i = 0; i < var_count; i ++ )
-        {
-            heap.content[ i ].first /= bump_size;
-        }
+        if ( keep_heap() )
+            heap.rescale( bump_size );
         bump_size = 1.0;
     }
 }
 
 void solver::bump( var_t var )
 {
-    heap.set_priority( var, heap.content[ heap.var_idx[ var ] ].first + bump_size );
+    if ( keep_heap() )
+        heap.bump( var, bump_size );
+    if ( keep_queue() )
+        queue_bumped.push_back( var );
+}
+
+/** Moves the variables bumped by the last conflict to the front of the
+ *  queue, in the order they had in it. */
+void solver::bump_queue()
+{
+    std::sort( queue_bumped.begin(), queue_bumped.end(), [&]( var_t a, var_t b ) {
+        return queue.stamp[ a ] < queue.stamp[ b ]; } );
+    for ( var_t v : queue_bumped )
+        queue.bump( v, values[ v ] == val_un );
+    queue_bumped.clear();
 }
 
 // Restarts
+/** Units stay at level 0 for good, so a restart only undoes the levels
+ *  above it. Moreover, the levels whose decisions are still more active
+ *  than the next decision would be taken again in the same order, so they
+ *  are kept as well. */
 void solver::restart()
 {
-    backtrack(0);
-    for ( idx_t i_c = 0; i_c < clauses.count; i_c++ )
-        if ( clauses.size( i_c ) == 1 )
-            unit_queue.push_back( i_c );
-    conflict_count = 0;
-    next_restart = luby_gen.next();
+    scoped_timer t( timer( RESTART ) );
+    ++stats.restarts;
+    restarts.restarted();
+
+    sidx_t level = reuse_trail_level();
+    stats.reused_levels += level;
+    backtrack( level );
+    target_assigned = 0;
+}
+
+
+/** Whether rephasing, importing the shared clauses or inprocessing is
+ *  due, which forces a restart. */
+bool solver::pass_due() const
+{
+    return ( rephase_interval > 0 && stats.conflicts >= next_rephase )
+        || ( share && stats.conflicts >= next_import )
+        || ( inprocessing && stats.conflicts >= next_inprocess );
+}
+
+
+/** The highest level whose decisions are all at least as active as the
+ *  best unassigned variable, or bumped later than it with VMTF. */
+sidx_t solver::reuse_trail_level()
+{
+    if ( use_queue() )
+    {
+        var_t next = queue.next( [&]( var_t u ) { return values[ u ] != val_un; } );
+        if ( next == 0 )
+            return 0;
+
+        sidx_t level = 0;
+        while ( level < decision_level
+             && queue.stamp[ var_of_lit( trail[ decisions[ level ] ] ) ] > queue.stamp[ next ] )
+            ++level;
+        return level;
+    }
+
+    while ( heap.size > 0 && values[ heap.top() ] != val_un )
+        heap.extract_max();
+
+    if ( heap.size == 0 )
+        return 0;
+
+    double next_activity = heap.priority( heap.top() );
+
+    sidx_t level = 0;
+    while ( level < decision_level )
+    {
+        var_t d = var_of_lit( trail[ decisions[ level ] ] );
+        if ( heap.priority( d ) < next_activity )
+            break;
+        ++level;
+    }
+    return level;
+}
+
+
+/// Inprocessing /////////////////////////////////////////////////////////////
+
+
+/** A simplification round at level 0, between restarts: failed literal
+ *  probing, substitution of equivalent literals and vivification, followed
+ *  by removing what the units found make redundant. Probing and
+ *  vivification get a share of the propagation work done by the search
+ *  since the previous round. Returns false if the formula turned out
+ *  unsatisfiable. */
+bool solver::inprocess()
+{
+    scoped_timer t( timer( INPROCESSING ) );
+    ++stats.inprocessings;
+    ++inprocess_count;
+    next_inprocess = stats.conflicts + 2000 * ( inprocess_count + 1 );
+
+    backtrack( 0 );
+    if ( ! propagate_units() )
+        return false;
+
+    size_t budget = std::max< size_t >( 50000, inprocess_effort * ( ticks() - inprocess_ticks ) );
+
+    // Probing and vivification assign literals of both signs, the saved
+    // phases of the search are kept.
+    std::vector< val_t > saved_phases = phases;
+
+    clean_level0();
+    if ( ! probe_failed( budget / 4 ) )
+        return false;
+
+    clean_level0();
+    if ( ! equivalent_literals() )
+        return false;
+
+    if ( ! vivify( budget - budget / 4 ) )
+        return false;
+    clean_level0();
+
+    // The level 0 literals are never resolved, their reasons may be gone.
+    for ( lit_t l : trail )
+        reason[ l ] = reason_t();
+    if ( clauses.wasted > clauses.memory.size() / 4 )
+        collect_garbage();
+
+    phases = std::move( saved_phases );
+    inprocess_ticks = ticks();
+    return true;
+}
+
+
+/** Propagates at level 0, a conflict there ends the proof. */
+bool solver::propagate_units()
+{
+    assert( decision_level == 0 );
+
+    sidx_t i_c = unit_propagation();
+    if ( i_c == idx_undef )
+        return true;
+
+    if ( lrat )
+        collect_hints( {}, i_c );
+    derive_empty();
+    inconsistent = true;
+    return false;
+}
+
+
+/** Removes the clauses satisfied at level 0 and the false literals of the
+ *  others, shortening them in place. The clauses of the formula kept in
+ *  the cnf_t are left as they are, unless satisfied. */
+void solver::clean_level0()
+{
+    assert( decision_level == 0 && qhead == trail.size() );
+
+    if ( cleaned_trail == trail.size() )
+        return;
+    cleaned_trail = trail.size();
+
+    write_units();
+
+    clause_t lits;
+    for ( cref_t c = clauses.begin(); c != clauses.end(); c = clauses.next( c ) )
+    {
+        if ( clauses.deleted( c ) )
+            continue;
+
+        bool satisfied = false;
+        lits.clear();
+        for ( size_t i_l = 0; i_l < clauses.size( c ) && ! satisfied; i_l++ )
+        {
+            lit_t l = clauses( c, i_l );
+            val_t v = eval_lit( l );
+            satisfied = v == val_tt;
+            if ( v == val_un )
+                lits.push_back( l );
+        }
+
+        if ( satisfied )
+        {
+            if ( proof )
+                proof->remove( lrat ? clauses.id( c ) : 0, clauses.lits( c )
+                             , clauses.lits( c ) + clauses.size( c ) );
+            clauses.remove( c );
+            continue;
+        }
+
+        if ( lits.size() == clauses.size( c ) || clauses.shared( c ) )
+            continue;
+
+        // Everything is propagated, so at least two literals are left.
+        assert( lits.size() >= 2 );
+        if ( lrat )
+        {
+            hints.clear();
+            for ( size_t i_l = 0; i_l < clauses.size( c ); i_l++ )
+                if ( eval_lit( clauses( c, i_l ) ) == val_ff )
+                    hints.push_back( unit_id[ var_of_lit( clauses( c, i_l ) ) ] );
+            hints.push_back( clauses.id( c ) );
+        }
+        replace_clause( c, lits );
+    }
+
+    // A binary clause with an assigned literal is satisfied.
+    for ( lit_t a = - lit_t( var_count ); a <= lit_t( var_count ); a++ )
+    {
+        auto &in = binary_in[ a ];
+        idx_t j = 0;
+        for ( idx_t i = 0; i < in.size(); i++ )
+        {
+            lit_t b = in[ i ];
+            if ( eval_lit( a ) == val_un && eval_lit( b ) == val_un )
+            {
+                if ( lrat )
+                    binary_ids[ a ][ j ] = binary_ids[ a ][ i ];
+                in[ j++ ] = b;
+            }
+            else if ( proof && a < b )
+            {
+                lit_t ab[] = { a, b };
+                proof->remove( lrat ? binary_ids[ a ][ i ] : 0, ab, ab + 2 );
+            }
+        }
+        in.resize( j );
+        if ( lrat )
+            binary_ids[ a ].resize( j );
+    }
+
+    rebuild_watches();
+}
+
+
+/** Adds the literals assigned at level 0 by propagation to a DRAT proof as
+ *  units, so that the proof does not depend on their reasons, which may
+ *  be deleted. In LRAT they have their unit clauses already. */
+void solver::write_units()
+{
+    for ( ; proof_units < trail.size(); proof_units++ )
+    {
+        lit_t l = trail[ proof_units ];
+        if ( proof && ! lrat && ! reason[ l ].empty() )
+            proof->add( &l, &l + 1, {} );
+    }
+}
+
+
+/** Propagates the roots of the binary implication graph, the literals not
+ *  implied by any other through a binary clause. The negation of a root
+ *  whose propagation fails is a new unit. */
+bool solver::probe_failed( size_t budget )
+{
+    size_t end = ticks() + budget;
+
+    for ( var_t i = 0; i < var_count && ticks() < end; i++ )
+    {
+        var_t v = probe_cursor++ % var_count + 1;
+
+        for ( lit_t l : { lit_t( v ), - lit_t( v ) } )
+        {
+            if ( eval_lit( l ) != val_un || implied_count( l ) > 0 || implied_count( -l ) == 0 )
+                continue;
+
+            decide( l );
+            sidx_t i_c = unit_propagation();
+            if ( i_c == idx_undef )
+            {
+                backtrack( 0 );
+                continue;
+            }
+
+            ++stats.failed_literals;
+            if ( lrat )
+                collect_hints( { -l }, i_c );
+            backtrack( 0 );
+
+            learn( { -l } );
+            assign( -l, reason_t() );
+            if ( ! propagate_units() )
+                return false;
+        }
+    }
+    return true;
+}
+
+
+/** Finds the strongly connected components of the binary implication
+ *  graph ( by Tarjan's algorithm ), their literals are all equivalent.
+ *  Each variable of a component is replaced by the one with the lowest
+ *  index everywhere. The replaced variables keep a fixed value and get
+ *  the right one when a model is found.
+ *
+ *  The rewritten clauses are derived before the old ones are deleted, as
+ *  they follow from them through the binary clauses. Not done with an
+ *  LRAT proof. */
+bool solver::equivalent_literals()
+{
+    if ( lrat )
+        return true;
+
+    literal_map< unsigned int > index( var_count, 0 );
+    literal_map< unsigned int > low( var_count, 0 );
+    literal_map< char > on_stack( var_count, 0 );
+    std::vector< lit_t > stack;
+    std::vector< std::pair< lit_t, idx_t > > dfs;
+    unsigned int counter = 0;
+
+    if ( substitute.empty() )
+        substitute.assign( var_count + 1, 0 );
+    std::vector< var_t > replaced;
+
+    auto visit = [&]( lit_t l ) {
+        index[ l ] = low[ l ] = ++counter;
+        stack.push_back( l );
+        on_stack[ l ] = 1;
+        dfs.push_back( { l, 0 } );
+    };
+
+    for ( var_t v = 1; v <= var_count; v++ )
+    {
+        for ( lit_t root : { lit_t( v ), - lit_t( v ) } )
+        {
+            if ( values[ v ] != val_un || index[ root ] != 0 )
+                continue;
+
+            visit( root );
+            while ( ! dfs.empty() )
+            {
+                lit_t u = dfs.back().first;
+                if ( dfs.back().second < implied_count( -u ) )
+                {
+                    lit_t w = implied( -u, dfs.back().second++ );
+                    if ( eval_lit( w ) != val_un )
+                        continue;
+                    if ( index[ w ] == 0 )
+                        visit( w );
+                    else if ( on_stack[ w ] )
+                        low[ u ] = std::min( low[ u ], index[ w ] );
+                    continue;
+                }
+
+                dfs.pop_back();
+                if ( ! dfs.empty() )
+                    low[ dfs.back().first ] = std::min( low[ dfs.back().first ], low[ u ] );
+                if ( low[ u ] != index[ u ] )
+                    continue;
+
+                // u is the root of a component, which is on the stack above it.
+                size_t first = stack.size();
+                lit_t rep = u;
+                do
+                {
+                    --first;
+                    on_stack[ stack[ first ] ] = 0;
+                    if ( var_of_lit( stack[ first ] ) < var_of_lit( rep ) )
+                        rep = stack[ first ];
+                } while ( stack[ first ] != u );
+
+                for ( size_t i = first; i < stack.size(); i++ )
+                {
+                    lit_t m = stack[ i ];
+                    if ( m == -rep )
+                    {
+                        // Both rep and -rep imply each other.
+                        if ( proof )
+                        {
+                            proof->add( &m, &m + 1, {} );
+                            proof->add( &rep, &rep + 1, {} );
+                        }
+                        hints.clear();
+                        derive_empty();
+                        inconsistent = true;
+                        return false;
+                    }
+                    if ( m != rep && substitute[ var_of_lit( m ) ] == 0 )
+                    {
+                        substitute[ var_of_lit( m ) ] = m > 0 ? rep : -rep;
+                        replaced.push_back( var_of_lit( m ) );
+                    }
+                }
+                stack.resize( first );
+            }
+        }
+    }
+
+    if ( replaced.empty() )
+        return true;
+
+    stats.substituted += replaced.size();
+    for ( var_t v = 1; v <= var_count; v++ )
+    {
+        lit_t r = substitute[ v ];
+        if ( r != 0 && substitute[ var_of_lit( r ) ] != 0 )
+            substitute[ v ] = representative( r );
+    }
+    for ( var_t v : replaced )
+        values[ v ] = val_ff;
+
+    // Rewrites the clauses, sorted by variable, without duplicates. The old
+    // ones are removed from the proof after all the new ones are added.
+    std::vector< clause_t > old_clauses;
+    std::vector< clause_t > copies;
+    std::vector< lit_t > new_units;
+    clause_t lits;
+
+    auto rewrite = [&]( const lit_t *first, const lit_t *last ) {
+        bool changed = false;
+        lits.clear();
+        for ( auto l = first; l != last; l++ )
+        {
+            lits.push_back( representative( *l ) );
+            changed |= lits.back() != *l;
+        }
+        if ( ! changed )
+            return false;
+
+        std::sort( lits.begin(), lits.end(), []( lit_t a, lit_t b ) {
+            return var_of_lit( a ) < var_of_lit( b ) || ( var_of_lit( a ) == var_of_lit( b ) && a < b );
+        } );
+        lits.erase( std::unique( lits.begin(), lits.end() ), lits.end() );
+        for ( idx_t i = 1; i < lits.size(); i++ )
+            if ( lits[ i ] == -lits[ i - 1 ] )
+            {
+                lits.clear();
+                break;
+            }
+
+        if ( proof )
+        {
+            old_clauses.emplace_back( first, last );
+            if ( ! lits.empty() )
+                proof->add( lits, {} );
+        }
+        return true;
+    };
+
+    for ( cref_t c = clauses.begin(); c != clauses.end(); c = clauses.next( c ) )
+    {
+        if ( clauses.deleted( c )
+          || ! rewrite( clauses.lits( c ), clauses.lits( c ) + clauses.size( c ) ) )
+            continue;
+
+        // An empty lits stands for a tautology here.
+        if ( lits.size() <= 2 || clauses.shared( c ) )
+        {
+            if ( lits.size() == 1 )
+                new_units.push_back( lits[ 0 ] );
+            else if ( lits.size() == 2 )
+                add_binary( lits[ 0 ], lits[ 1 ] );
+            else if ( lits.size() > 2 )
+                copies.push_back( lits );
+            clauses.remove( c );
+        }
+        else
+            clauses.shrink( c, lits.data(), lits.data() + lits.size() );
+    }
+
+    own_binaries();
+    std::vector< std::pair< lit_t, lit_t > > binaries;
+    for ( lit_t a = - lit_t( var_count ); a <= lit_t( var_count ); a++ )
+    {
+        for ( lit_t b : binary_in[ a ] )
+            if ( a < b )
+                binaries.push_back( { a, b } );
+        binary_in[ a ].clear();
+    }
+    for ( auto [ a, b ] : binaries )
+    {
+        lit_t ab[] = { a, b };
+        if ( ! rewrite( ab, ab + 2 ) )
+            add_binary( a, b );
+        else if ( lits.size() == 1 )
+            new_units.push_back( lits[ 0 ] );
+        else if ( lits.size() == 2 )
+            add_binary( lits[ 0 ], lits[ 1 ] );
+    }
+
+    for ( auto &c : old_clauses )
+        proof->remove( 0, c.data(), c.data() + c.size() );
+
+    for ( auto &c : copies )
+        clauses.add( c );
+    rebuild_watches();
+
+    for ( lit_t l : new_units )
+    {
+        if ( eval_lit( l ) == val_ff )
+        {
+            hints.clear();
+            derive_empty();
+            inconsistent = true;
+            return false;
+        }
+        if ( eval_lit( l ) == val_un )
+            assign( l, reason_t() );
+    }
+    return propagate_units();
+}
+
+
+/** Shortens clauses by propagating the negations of their literals one by
+ *  one. A conflict means that the literals so far form a clause implied by
+ *  the formula, as does a literal which turns out true, together with the
+ *  ones before it. False literals are left out. The learnt clauses of low
+ *  lbd go first, then the clauses of the formula, each only once. */
+bool solver::vivify( size_t budget )
+{
+    std::vector< cref_t > candidates;
+    for ( cref_t c = clauses.begin(); c != clauses.end(); c = clauses.next( c ) )
+        if ( ! clauses.deleted( c ) && ! clauses.shared( c ) && ! clauses.vivified( c )
+          && ( ! clauses.learnt( c ) || clauses.lbd( c ) <= 6 ) )
+            candidates.push_back( c );
+
+    std::stable_sort( candidates.begin(), candidates.end(), [&]( cref_t a, cref_t b ) {
+        unsigned int lbd_a = clauses.learnt( a ) ? clauses.lbd( a ) : UINT_MAX;
+        unsigned int lbd_b = clauses.learnt( b ) ? clauses.lbd( b ) : UINT_MAX;
+        return lbd_a < lbd_b;
+    } );
+
+    size_t end = ticks() + budget;
+    clause_t lits;
+    clause_t kept;
+
+    for ( cref_t c : candidates )
+    {
+        if ( ticks() >= end )
+            break;
+        if ( clauses.deleted( c ) )
+            continue;
+        clauses.set_vivified( c );
+
+        lits.assign( clauses.lits( c ), clauses.lits( c ) + clauses.size( c ) );
+        if ( std::any_of( lits.begin(), lits.end(), [&]( lit_t l ) { return eval_lit( l ) == val_tt; } ) )
+            continue;
+
+        kept.clear();
+        sidx_t i_c = idx_undef;
+        lit_t implied = 0;
+        for ( lit_t l : lits )
+        {
+            val_t v = eval_lit( l );
+            if ( v == val_ff )
+                continue;
+            kept.push_back( l );
+            if ( v == val_tt )
+            {
+                implied = l;
+                break;
+            }
+            decide( -l );
+            if ( ( i_c = unit_propagation() ) != idx_undef )
+                break;
+        }
+
+        if ( kept.size() == lits.size() || ( i_c == idx_undef && implied == 0 ) )
+        {
+            backtrack( 0 );
+            continue;
+        }
+
+        if ( lrat )
+        {
+            if ( i_c == idx_undef )
+            {
+                // The reason of the true literal plays the conflict.
+                reason_t why = reason[ implied ];
+                i_c = why.clause;
+                if ( why.clause == idx_undef )
+                {
+                    binary_conflict = { why.binary, implied };
+                    i_c = idx_binary;
+                }
+            }
+            collect_hints( kept, i_c );
+        }
+        backtrack( 0 );
+
+        ++stats.vivified;
+        stats.vivified_literals += lits.size() - kept.size();
+
+        detach( c );
+        replace_clause( c, kept );
+        if ( ! clauses.deleted( c ) )
+            attach( c );
+        if ( kept.size() == 1 && ! propagate_units() )
+            return false;
+    }
+    return true;
+}
+
+
+/** Replaces the clause c by the shorter one made of lits, which follows
+ *  from the formula by the hints. The clause has to be detached. */
+void solver::replace_clause( cref_t c, const clause_t &lits )
+{
+    uint64_t id = 0;
+    if ( proof )
+    {
+        id = proof->add( lits, hints );
+        proof->remove( lrat ? clauses.id( c ) : 0, clauses.lits( c )
+                     , clauses.lits( c ) + clauses.size( c ) );
+    }
+
+    if ( lits.size() == 1 )
+    {
+        clauses.remove( c );
+        if ( lrat )
+            unit_id[ var_of_lit( lits[ 0 ] ) ] = id;
+        assign( lits[ 0 ], reason_t() );
+    }
+    else if ( lits.size() == 2 )
+    {
+        clauses.remove( c );
+        add_binary( lits[ 0 ], lits[ 1 ], id );
+    }
+    else
+    {
+        clauses.shrink( c, lits.data(), lits.data() + lits.size() );
+        if ( lrat )
+            clauses.set_id( c, id );
+    }
+}
+
+
+void solver::attach( cref_t c )
+{
+    lit_t *w = clauses.watched( c );
+    watched_in[ w[ 0 ] ].push_back( { c, w[ 1 ] } );
+    watched_in[ w[ 1 ] ].push_back( { c, w[ 0 ] } );
+}
+
+
+void solver::detach( cref_t c )
+{
+    lit_t *w = clauses.watched( c );
+    for ( lit_t l : { w[ 0 ], w[ 1 ] } )
+    {
+        auto &list = watched_in[ l ];
+        auto it = std::find_if( list.begin(), list.end(), [&]( const watcher &wa ) {
+            return wa.clause == c;
+        } );
+        assert( it != list.end() );
+        list.erase( it );
+    }
+}
+
+
+void solver::rebuild_watches()
+{
+    for ( auto &w : watched_in.content )
+        w.clear();
+    for ( cref_t c = clauses.begin(); c != clauses.end(); c = clauses.next( c ) )
+        if ( ! clauses.deleted( c ) )
+            attach( c );
+}
+
+
+/// Incremental use //////////////////////////////////////////////////////////
+
+
+void solver::add_clause( const clause_t &c )
+{
+    assert( proof == nullptr );
+
+    backtrack( 0 );
+
+    var_t max_var = 0;
+    for ( lit_t l : c )
+        max_var = std::max( max_var, var_of_lit( l ) );
+    if ( max_var > var_count )
+        grow( max_var );
+
+    // Literals false at level 0 are left out, satisfied clauses and
+    // tautologies are not needed at all.
+    clause_t d;
+    for ( lit_t l : c )
+    {
+        l = representative( l );
+        val_t v = eval_lit( l );
+        if ( v == val_tt || std::find( d.begin(), d.end(), -l ) != d.end() )
+            return;
+        if ( v == val_un && std::find( d.begin(), d.end(), l ) == d.end() )
+            d.push_back( l );
+    }
+
+    if ( d.empty() )
+        inconsistent = true;
+    else if ( d.size() == 1 )
+        assign( d[ 0 ], reason_t() );
+    else if ( d.size() == 2 )
+        add_binary( d[ 0 ], d[ 1 ] );
+    else
+        attach( clauses.add( d ) );
+}
+
+
+/** Adds the variables up to new_count. */
+void solver::grow( unsigned int new_count )
+{
+    assert( new_count >= var_count );
+    assert( ! lrat );
+
+    // phases[ 0 ] is not used by any variable, it keeps the initial phase.
+    values.resize( new_count + 1, val_un );
+    phases.resize( new_count + 1, phases[ 0 ] );
+    target_phases.resize( new_count + 1, val_un );
+    best_phases.resize( new_count + 1, val_un );
+    level_stamp.resize( new_count + 1, 0 );
+    if ( ! core_mark.empty() )
+        core_mark.resize( new_count + 1, 0 );
+
+    own_binaries();
+    watched_in.resize( new_count );
+    binary_in.resize( new_count );
+    lit_level.resize( new_count, -1 );
+    reason.resize( new_count, reason_t() );
+    to_resolve.resize( new_count );
+    learnt_lit.resize( new_count );
+    heap.resize( new_count );
+    queue.resize( new_count );
+    if ( ! substitute.empty() )
+        substitute.resize( new_count + 1, 0 );
+
+    var_count = new_count;
+}
+
+
+/** Collects the assumptions which made the assumption a false: the
+ *  decisions among the literals its negation was implied from. */
+void solver::analyze_final( lit_t a )
+{
+    core.assign( 1, a );
+    if ( lit_level[ -a ] == 0 )
+        return;
+
+    core_mark.resize( var_count + 1, 0 );
+    core_mark[ var_of_lit( a ) ] = 1;
+
+    auto mark = [&]( lit_t r ) {
+        if ( lit_level[ -r ] > 0 )
+            core_mark[ var_of_lit( r ) ] = 1;
+    };
+
+    for ( idx_t i = trail.size(); i-- > decisions[ 0 ]; )
+    {
+        lit_t t = trail[ i ];
+        if ( ! core_mark[ var_of_lit( t ) ] )
+            continue;
+        core_mark[ var_of_lit( t ) ] = 0;
+
+        reason_t why = reason[ t ];
+        if ( why.empty() )
+            core.push_back( t );
+        else if ( why.clause == idx_undef )
+            mark( why.binary );
+        else
+        {
+            for ( size_t i_l = 0; i_l < clauses.size( why.clause ); i_l++ )
+                if ( clauses( why.clause, i_l ) != t )
+                    mark( clauses( why.clause, i_l ) );
+        }
+    }
+}
+
+
+/// Lookahead ////////////////////////////////////////////////////////////////
+
+
+/** Decides l on a new level and propagates it. Returns the number of
+ *  literals assigned, or -1 on a conflict. The level is undone. */
+long solver::probe( lit_t l )
+{
+    size_t before = trail.size();
+    decide( l );
+    bool conflict = unit_propagation() != idx_undef;
+    long assigned = trail.size() - before;
+    backtrack( decision_level - 1 );
+    return conflict ? -1 : assigned;
+}
+
+
+/** Chooses a variable to split the cube on. Both literals of each of the
+ *  most active unassigned variables are propagated under the cube, the
+ *  variable whose two sides assign the most ( by the product of the
+ *  counts ) is taken. A side which fails refutes its half of the cube at
+ *  once, which makes the variable the best choice.
+ *
+ *  Returns the positive literal of the variable, 0 if propagating the cube
+ *  itself fails ( refuted is set ) or if it leaves nothing to split on. */
+lit_t solver::lookahead( const std::vector< lit_t > &cube, size_t candidates, bool &refuted )
+{
+    refuted = false;
+    backtrack( 0 );
+
+    if ( inconsistent || empty_clause || ! assign_units() )
+    {
+        refuted = true;
+        return 0;
+    }
+
+    auto fail = [&]{
+        backtrack( 0 );
+        refuted = true;
+        return 0;
+    };
+
+    if ( unit_propagation() != idx_undef )
+    {
+        inconsistent = true;
+        return fail();
+    }
+
+    for ( lit_t a : cube )
+    {
+        a = representative( a );
+        val_t v = eval_lit( a );
+        if ( v == val_ff )
+            return fail();
+        if ( v == val_tt )
+            continue;
+        decide( a );
+        if ( unit_propagation() != idx_undef )
+            return fail();
+    }
+
+    std::vector< var_t > vars;
+    for ( var_t v = 1; v <= var_count; v++ )
+        if ( values[ v ] == val_un )
+            vars.push_back( v );
+
+    size_t count = std::min( candidates, vars.size() );
+    std::partial_sort( vars.begin(), vars.begin() + count, vars.end()
+                     , [&]( var_t a, var_t b ) {
+                           return use_queue() ? queue.stamp[ a ] > queue.stamp[ b ]
+                                              : heap.priority( a ) > heap.priority( b ); } );
+
+    lit_t best = 0;
+    double best_score = -1;
+    for ( idx_t i = 0; i < count; i++ )
+    {
+        lit_t l = vars[ i ];
+        long pos = probe( l );
+        long neg = probe( -l );
+        if ( pos < 0 && neg < 0 )
+            return fail();
+
+        double score = pos < 0 || neg < 0 ? HUGE_VAL : double( pos + 1 ) * double( neg + 1 );
+        if ( score > best_score )
+        {
+            best = l;
+            best_score = score;
+        }
+        if ( score == HUGE_VAL )
+            break;
+    }
+
+    backtrack( 0 );
+    return best;
+}
+
+
+/// Clause sharing ////////////////////////////////////////////////////////////
+
+
+void solver::export_clause( const clause_t &c, unsigned int lbd )
+{
+    if ( share->accepts( c.size(), lbd )
+      && share->push( c.data(), c.data() + c.size(), lbd, share_id ) )
+        ++stats.exported;
+}
+
+
+/** Adds the clauses exported by the other solvers since the last call.
+ *  They are attached at level 0, so the solver backtracks there first if
+ *  there are any. Returns false if the formula turned out unsatisfiable. */
+bool solver::import_shared()
+{
+    next_import = stats.conflicts + import_interval;
+    uint64_t head = share->head.load( std::memory_order_acquire );
+    if ( share_cursor == head )
+        return true;
+    if ( head - share_cursor > share->capacity )
+        share_cursor = head - share->capacity;
+
+    backtrack( 0 );
+
+    for ( ; share_cursor < head; share_cursor++ )
+    {
+        unsigned int lbd, owner;
+        auto r = share->read( share_cursor, import_buffer, lbd, owner );
+        if ( r == clause_ring::WAIT )
+            break;
+        if ( r == clause_ring::SKIP || owner == share_id )
+            continue;
+        if ( ! import_clause( import_buffer, lbd ) )
+            return false;
+    }
+    return true;
+}
+
+
+/** Attaches the clause at level 0 without its false literals. Returns
+ *  false if all of them are false. */
+bool solver::import_clause( clause_t &c, unsigned int lbd )
+{
+    assert( decision_level == 0 );
+
+    // The other solvers may not have replaced the same variables.
+    idx_t j = 0;
+    for ( lit_t l : c )
+    {
+        l = representative( l );
+        val_t v = eval_lit( l );
+        if ( v == val_tt || std::find( c.begin(), c.begin() + j, -l ) != c.begin() + j )
+            return true;
+        if ( v == val_un && std::find( c.begin(), c.begin() + j, l ) == c.begin() + j )
+            c[ j++ ] = l;
+    }
+    c.resize( j );
+    ++stats.imported;
+
+    if ( c.empty() )
+        return false;
+
+    if ( c.size() == 1 )
+        assign( c[ 0 ], reason_t() );
+    else if ( c.size() == 2 )
+        add_binary( c[ 0 ], c[ 1 ] );
+    else
+        attach( clauses.add( c, true, std::min< size_t >( lbd, c.size() ) ) );
+    return true;
+}
+
+
+/** Assigns the unit clauses of the formula at level 0, returns false if
+ *  they contradict each other. */
+bool solver::assign_units()
+{
+    assert( decision_level == 0 );
+
+    for ( idx_t i = 0; i < units.size(); i++ )
+    {
+        lit_t l = units[ i ];
+        if ( eval_lit( l ) == val_ff )
+        {
+            if ( lrat )
+                hints = { unit_id[ var_of_lit( l ) ], unit_clause_ids[ i ] };
+            derive_empty();
+            return false;
+        }
+        if ( eval_lit( l ) == val_un )
+        {
+            if ( lrat )
+                unit_id[ var_of_lit( l ) ] = unit_clause_ids[ i ];
+            assign( l, reason_t() );
+        }
+    }
+    return true;
+}
+
+
+/// Proof //////////////////////////////////////////////////////////////////////
+
+
+/** Id of the binary clause ( a, b ). */
+uint64_t solver::binary_id( lit_t a, lit_t b )
+{
+    auto &in = binary_in[ a ];
+    for ( idx_t i = 0; i < in.size(); i++ )
+        if ( in[ i ] == b )
+            return binary_ids[ a ][ i ];
+
+    assert( false );
+    return 0;
+}
+
+
+/** Id of the clause which implied l. */
+uint64_t solver::reason_id( reason_t why, lit_t l )
+{
+    if ( why.clause != idx_undef )
+        return clauses.id( why.clause );
+    return binary_id( why.binary, l );
+}
+
+
+/** Adds to hints the ids of the clauses which make the false literal l
+ *  false by unit propagation from the literals marked in hint_mark, each
+ *  after the ones it depends on. Literals false at level 0 are justified
+ *  by their unit clause. */
+void solver::justify( lit_t l )
+{
+    hint_stack.push_back( { l, false } );
+
+    while ( ! hint_stack.empty() )
+    {
+        auto [ q, expanded ] = hint_stack.back();
+        var_t v = var_of_lit( q );
+
+        if ( expanded )
+        {
+            hints.push_back( reason_id( reason[ -q ], -q ) );
+            hint_stack.pop_back();
+            continue;
+        }
+
+        if ( hint_mark[ v ] )
+        {
+            hint_stack.pop_back();
+            continue;
+        }
+
+        hint_mark[ v ] = 1;
+        hint_clear.push_back( v );
+
+        if ( lit_level[ -q ] == 0 )
+        {
+            hints.push_back( unit_id[ v ] );
+            hint_stack.pop_back();
+            continue;
+        }
+
+        hint_stack.back().second = true;
+
+        reason_t why = reason[ -q ];
+        assert( ! why.empty() );
+        if ( why.clause == idx_undef )
+            hint_stack.push_back( { why.binary, false } );
+        else
+        {
+            for ( size_t i_l = 0; i_l < clauses.size( why.clause ); i_l++ )
+            {
+                lit_t r = clauses( why.clause, i_l );
+                if ( r != -q && ! hint_mark[ var_of_lit( r ) ] )
+                    hint_stack.push_back( { r, false } );
+            }
+        }
+    }
+}
+
+
+/** Collects the LRAT hints of a clause learnt from the conflict i_c: the
+ *  reasons of all the false literals which were resolved away or removed
+ *  by minimization, in the order of the trail, and the conflict last. */
+void solver::collect_hints( const clause_t &learnt_clause, sidx_t i_c )
+{
+    hints.clear();
+    for ( lit_t l : learnt_clause )
+    {
+        hint_mark[ var_of_lit( l ) ] = 1;
+        hint_clear.push_back( var_of_lit( l ) );
+    }
+
+    if ( i_c == idx_binary )
+    {
+        justify( binary_conflict.first );
+        justify( binary_conflict.second );
+        hints.push_back( binary_id( binary_conflict.first, binary_conflict.second ) );
+    }
+    else
+    {
+        for ( size_t i_l = 0; i_l < clauses.size( i_c ); i_l++ )
+            justify( clauses( i_c, i_l ) );
+        hints.push_back( clauses.id( i_c ) );
+    }
+
+    for ( var_t v : hint_clear )
+        hint_mark[ v ] = 0;
+    hint_clear.clear();
+}
+
+
+/** LRAT needs a unit clause for every literal assigned at level 0, the
+ *  ones implied by propagation get it derived here. */
+void solver::derive_unit( lit_t l, reason_t why )
+{
+    hints.clear();
+    if ( why.clause == idx_undef )
+        hints.push_back( unit_id[ var_of_lit( why.binary ) ] );
+    else
+    {
+        for ( size_t i_l = 0; i_l < clauses.size( why.clause ); i_l++ )
+        {
+            lit_t r = clauses( why.clause, i_l );
+            if ( r != l )
+                hints.push_back( unit_id[ var_of_lit( r ) ] );
+        }
+    }
+    hints.push_back( reason_id( why, l ) );
+
+    unit_id[ var_of_lit( l ) ] = proof->add( &l, &l + 1, hints );
+}
+
+
+/** Ends the proof with the empty clause, using the hints collected by the
+ *  caller in LRAT mode. */
+void solver::derive_empty()
+{
+    if ( proof )
+        proof->add( {}, hints );
 }
@@ -1,13 +1,24 @@
 #pragma once
 
 #include "base.hpp"
-#include "sequences.hpp"
+#include "heap.hpp"
+#include "queue.hpp"
+#include "restart.hpp"
+#include "proof.hpp"
+#include "share.hpp"
+#include "sls.hpp"
+#include "timer.hpp"
 
 #include <vector>
 #include <deque>
 #include <cmath>
 #include <cassert>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <ostream>
+#include <random>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -48,162 +59,449 @@ struct literal_set
             --size;
         el = 0;
     }
+
+    void resize( size_t new_count )
+    {
+        std::vector< char > moved( new_count * 2 + 1 );
+        for ( lit_t l = - lit_t( var_count ); l <= lit_t( var_count ); l++ )
+            moved[ l + new_count ] = content[ l + var_count ];
+        content.swap( moved );
+        var_count = new_count;
+    }
 };
 
-struct var_heap
+/** Reference of a clause, its offset in the clause arena. */
+using cref_t = uint32_t;
+
+/** All long clauses in one block of 32-bit words. A clause is stored
+ *  contiguously: a header word ( size, learnt, deleted, relocated, shared
+ *  and vivified flags ), the lbd, the activity and then the literals. With
+ *  an LRAT proof the literals are followed by the 64-bit id of the clause.
+ *
+ *  A clause shortened in place leaves the words it does not need any more
+ *  as padding, a deleted header whose size is the number of the words.
+ *
+ *  A shared clause is a clause of the formula whose literals stay in the
+ *  read-only cnf_t, so that solvers running in parallel do not copy them.
+ *  The arena keeps only the header, the offset of the literals in
+ *  cnf_t::literals and the two watched literals. Shared clauses are never
+ *  learnt, so they need no lbd or activity. */
+struct clause_arena
 {
-    std::vector< std::pair< double, var_t > > content;
+    static constexpr size_t header_size = 3;
+    static constexpr size_t shared_size = 4;
 
-    std::vector< size_t > var_idx;
+    static constexpr uint32_t learnt_bit  = 1u << 31;
+    static constexpr uint32_t deleted_bit = 1u << 30;
+    static constexpr uint32_t reloced_bit = 1u << 29;
+    static constexpr uint32_t shared_bit  = 1u << 28;
+    static constexpr uint32_t padding_bit = 1u << 27;
+    static constexpr uint32_t vivified_bit = 1u << 26;
+    static constexpr uint32_t size_mask   = vivified_bit - 1;
 
-    size_t var_count;
+    std::vector< uint32_t > memory;
 
-    size_t size;
+    // Clauses which are not deleted, of those learnt_count are learnt.
+    size_t count = 0;
+    size_t learnt_count = 0;
+    size_t wasted = 0;
+
+    // Words after the literals, 2 when the clauses carry proof ids.
+    size_t trailer = 0;
+
+    // Literals of the shared clauses.
+    const lit_t *shared_lits = nullptr;
+
+    clause_arena() = default;
 
-    size_t parent( size_t i )
+    size_t size( cref_t c ) const
     {
-        return i / 2;
+        return memory[ c ] & size_mask;
     }
 
-    size_t left( size_t i )
+    bool learnt( cref_t c ) const
     {
-        return 2 * i + 1;
+        return memory[ c ] & learnt_bit;
     }
 
-    size_t right( size_t i)
+    bool deleted( cref_t c ) const
     {
-        return 2 * i + 2;
+        return memory[ c ] & deleted_bit;
     }
 
-    var_heap( size_t var_count ) : var_count( var_count ), size( var_count )
+    bool shared( cref_t c ) const
     {
-        content.resize( var_count );
-        var_idx.resize( var_count + 1 );
+        return memory[ c ] & shared_bit;
+    }
 
-        for ( size_t i = 0; i < var_count; i++ )
-        {
-            var_idx[ i + 1 ] = i;
-            content[ i ] = { 0.0, i + 1 };
-        }
+    bool vivified( cref_t c ) const
+    {
+        return memory[ c ] & vivified_bit;
     }
 
-    void push( var_t var )
+    void set_vivified( cref_t c )
     {
-        if ( var_idx[ var ] < size )
-            return;
+        memory[ c ] |= vivified_bit;
+    }
 
-        swap( size, var_idx[ var ] );
-        ++ size;
-        move_up( size - 1 );
+    unsigned int lbd( cref_t c ) const
+    {
+        assert( ! shared( c ) );
+        return memory[ c + 1 ];
     }
 
-    void set_priority( var_t var, double p )
+    void set_lbd( cref_t c, unsigned int lbd )
     {
-        content[ var_idx[ var ] ].first = p;
+        assert( ! shared( c ) );
+        memory[ c + 1 ] = lbd;
+    }
 
-        if ( var_idx[ var ] < size )
-        {
-            move_up( var_idx[ var ] );
-            move_down( var_idx[ var ] );
-        }
+    float activity( cref_t c ) const
+    {
+        assert( ! shared( c ) );
+        float a;
+        std::memcpy( &a, &memory[ c + 2 ], sizeof( float ) );
+        return a;
     }
 
-    void move_up( size_t i )
+    void set_activity( cref_t c, float a )
     {
-        while ( content[ i ].first > content[ parent( i ) ].first && i != 0 )
-        {
-            swap( i,  parent( i ) );
-            i = parent( i );
-        }
+        assert( ! shared( c ) );
+        std::memcpy( &memory[ c + 2 ], &a, sizeof( float ) );
     }
 
-    void move_down( size_t i )
+    /** Number of words taken by the clause without the trailer. */
+    size_t body( cref_t c ) const
     {
-        while ( left( i ) < size )
-        {
-            size_t max_child = left( i );
-            if ( right ( i ) < size && content[ right( i ) ].first > content[ left(i) ].first )
-                max_child = right( i );
+        return shared( c ) ? shared_size : header_size + size( c );
+    }
 
-            if ( content[ max_child ].first <= content[ i ].first )
-                break;
+    const lit_t *lits( cref_t c ) const
+    {
+        if ( shared( c ) )
+            return shared_lits + memory[ c + 1 ];
+        return reinterpret_cast< const lit_t * >( &memory[ c + header_size ] );
+    }
 
-            swap( i, max_child );
-            i = max_child;
-        }
+    /** The two watched literals, the first two literals of an owned clause
+     *  and a copy of them for a shared one. For an owned clause the other
+     *  literals follow. */
+    lit_t *watched( cref_t c )
+    {
+        if ( shared( c ) )
+            return reinterpret_cast< lit_t * >( &memory[ c + 2 ] );
+        return reinterpret_cast< lit_t * >( &memory[ c + header_size ] );
     }
 
-    var_t extract_max()
+    uint64_t id( cref_t c ) const
     {
-        assert( size != 0 );
+        assert( trailer == 2 );
+        const uint32_t *t = &memory[ c + body( c ) ];
+        return uint64_t( t[ 0 ] ) | uint64_t( t[ 1 ] ) << 32;
+    }
 
-        var_t var = content[ 0 ].second;
-        swap( 0, size - 1);
-        -- size;
-        if (size > 0)
-            move_down( 0 );
+    void set_id( cref_t c, uint64_t id )
+    {
+        assert( trailer == 2 );
+        uint32_t *t = &memory[ c + body( c ) ];
+        t[ 0 ] = uint32_t( id );
+        t[ 1 ] = uint32_t( id >> 32 );
+    }
 
-        return var;
+    lit_t operator() ( cref_t c, size_t i_l ) const
+    {
+        #ifdef CHECKED
+            assert( c < memory.size() && ! deleted( c ) );
+            assert( i_l < size( c ) );
+        #endif
+        return lits( c )[ i_l ];
     }
 
-    void swap( size_t i, size_t j )
+    // Iteration over all clauses, including the deleted ones.
+
+    cref_t begin() const
     {
-        std::swap( var_idx[ content[ i ].second ], var_idx[ content[ j ].second ] );
-        std::swap( content[ i ], content [ j ] );
+        return 0;
     }
-};
 
-struct clause_collection
-{
-    std::vector< lit_t > content_1;
-    std::vector< lit_t > content_2;
-    std::vector< lit_t > content_rest;
-    std::vector< size_t > beginnings;
-    std::vector< size_t > sizes;
-    size_t count;
+    cref_t end() const
+    {
+        return memory.size();
+    }
 
-    clause_collection( std::vector< clause_t > formula ) : content_1(), content_2(), beginnings(), count( 0 )
+    cref_t next( cref_t c ) const
     {
-        for ( auto &clause : formula )
-        {
-            add( clause );
-        }
+        if ( memory[ c ] & padding_bit )
+            return c + size( c );
+        return c + body( c ) + trailer;
     }
 
-    size_t size( idx_t i )
+    cref_t add( const lit_t *first, const lit_t *last
+              , bool is_learnt = false, unsigned int lbd = 0 )
     {
-        return sizes[ i ];
+        size_t size = last - first;
+        assert( size <= size_mask );
+
+        cref_t c = memory.size();
+        memory.push_back( size | ( is_learnt ? learnt_bit : 0 ) );
+        memory.push_back( lbd );
+        memory.push_back( 0 );
+        memory.insert( memory.end(), first, last );
+        memory.resize( memory.size() + trailer, 0 );
+        set_activity( c, 0.0 );
+        ++count;
+        learnt_count += is_learnt;
+        return c;
     }
 
-    lit_t& operator() ( size_t i_c, size_t i_l )
+    cref_t add( const clause_t &clause, bool is_learnt = false, unsigned int lbd = 0 )
     {
-        #ifdef CHECKED
-            assert( i_c >= 0 && i_c < count );
-            assert( i_l < size( i_c ));
-        #endif
-        if ( i_l == 0)
-            return content_1[ i_c ];
-        if ( i_l == 1 )
-            return content_2[ i_c ];
-        return content_rest[ beginnings[ i_c ] + i_l - 2 ];
+        return add( clause.data(), clause.data() + clause.size(), is_learnt, lbd );
     }
 
-    void add( clause_t &clause )
+    /** Adds the clause of size literals at offset in shared_lits. */
+    cref_t add_shared( size_t offset, size_t size )
     {
+        assert( size <= size_mask && size >= 2 );
+        assert( offset <= UINT32_MAX );
+
+        cref_t c = memory.size();
+        memory.push_back( size | shared_bit );
+        memory.push_back( offset );
+        memory.push_back( shared_lits[ offset ] );
+        memory.push_back( shared_lits[ offset + 1 ] );
+        memory.resize( memory.size() + trailer, 0 );
         ++count;
-        sizes.push_back( clause.size() );
-        content_1.push_back( clause[ 0 ] );
-        beginnings.push_back( content_rest.size() );
-        if ( clause.size() > 1 )
+        return c;
+    }
+
+    /** Replaces the literals of the owned clause c by the ones from first
+     *  to last, which may be fewer. */
+    void shrink( cref_t c, const lit_t *first, const lit_t *last )
+    {
+        assert( ! shared( c ) && ! deleted( c ) );
+        size_t new_size = last - first;
+        assert( new_size <= size( c ) );
+
+        cref_t old_next = next( c );
+        uint64_t old_id = trailer ? id( c ) : 0;
+
+        std::copy( first, last, watched( c ) );
+        memory[ c ] = ( memory[ c ] & ~size_mask ) | new_size;
+        if ( trailer )
+            set_id( c, old_id );
+
+        cref_t n = next( c );
+        if ( n < old_next )
         {
-            content_2.push_back( clause[ 1 ] );
-            content_rest.insert( content_rest.end(), clause.begin() + 2, clause.end() );
+            memory[ n ] = deleted_bit | padding_bit | ( old_next - n );
+            wasted += old_next - n;
         }
-        else
+    }
+
+    void remove( cref_t c )
+    {
+        assert( ! deleted( c ) );
+        memory[ c ] |= deleted_bit;
+        wasted += body( c ) + trailer;
+        --count;
+        learnt_count -= learnt( c );
+    }
+
+    /** Copies the clauses which are not deleted to the arena to, leaving
+     *  the new reference in the old header. The references are then
+     *  translated by forward. */
+    void move_to( clause_arena &to )
+    {
+        to.trailer = trailer;
+        to.shared_lits = shared_lits;
+        to.memory.reserve( memory.size() - wasted );
+        for ( cref_t c = begin(); c != end(); c = next( c ) )
         {
-            content_2.push_back( 0 );
+            if ( deleted( c ) )
+                continue;
+
+            cref_t n = to.memory.size();
+            to.memory.insert( to.memory.end()
+                            , memory.begin() + c
+                            , memory.begin() + next( c ) );
+            ++to.count;
+            to.learnt_count += learnt( c );
+
+            memory[ c ] |= reloced_bit;
+            memory[ c + 1 ] = n;
         }
     }
+
+    cref_t forward( cref_t c ) const
+    {
+        assert( memory[ c ] & reloced_bit );
+        return memory[ c + 1 ];
+    }
+};
+
+
+/** The binary clauses of a formula as implication lists in one block, read
+ *  only, so that the solvers of a portfolio share them: ( a, b ) puts b in
+ *  the list of a and a in the list of b, as solver::binary_in does.
+ *  Tautologies are left out. */
+struct binary_lists
+{
+    unsigned int var_count = 0;
+
+    // The list of l is lits[ start[ l + var_count ] ] up to the start of
+    // the next literal.
+    std::vector< size_t > start;
+    std::vector< lit_t > lits;
+
+    explicit binary_lists( const cnf_t &cnf );
+
+    clause_view operator[]( lit_t l ) const
+    {
+        const size_t *s = &start[ l + var_count ];
+        return { lits.data() + s[ 0 ], lits.data() + s[ 1 ] };
+    }
+
+    size_t count() const
+    {
+        return lits.size() / 2;
+    }
+};
+
+
+/** Entry of a watch list. The blocker is some other literal of the clause,
+ *  if it is true the clause is satisfied and does not have to be visited. */
+struct watcher
+{
+    cref_t clause;
+    lit_t blocker;
+};
+
+/** Why a literal was assigned. Either a clause of the clause collection,
+ *  or a binary clause given by its other (false) literal, or nothing for
+ *  decisions. */
+struct reason_t
+{
+    sidx_t clause = idx_undef;
+    lit_t binary = 0;
+
+    bool empty() const
+    {
+        return clause == idx_undef && binary == 0;
+    }
+};
+
+/** Returned instead of a clause index when the conflict is in a binary
+ *  clause, the clause is then stored in solver::binary_conflict. */
+const sidx_t idx_binary = -2;
+
+struct solver_stats
+{
+    size_t conflicts = 0;
+    size_t decisions = 0;
+    size_t propagations = 0;
+    size_t binary_propagations = 0;
+    size_t restarts = 0;
+    size_t reused_levels = 0;
+    size_t reductions = 0;
+    size_t learnt_literals = 0;
+    size_t minimized_literals = 0;
+    size_t watcher_visits = 0;
+    size_t blocker_hits = 0;
+    size_t exported = 0;
+    size_t imported = 0;
+    size_t inprocessings = 0;
+    size_t failed_literals = 0;
+    size_t vivified = 0;
+    size_t vivified_literals = 0;
+    size_t substituted = 0;
+    size_t rephases = 0;
+    size_t walks = 0;
+    size_t walk_flips = 0;
+    double walk_seconds = 0;
+    size_t chrono_backtracks = 0;
+    size_t chrono_kept = 0;
+};
+
+/** The parts of the search which are timed when profiling. */
+enum phase_t
+{
+    PROPAGATION, ANALYSIS, RESTART, REDUCTION, INPROCESSING, LOCAL_SEARCH, PHASE_COUNT
+};
+
+
+/** How the decision variables are picked: the most active one ( VSIDS ),
+ *  the most recently bumped one ( VMTF ), or VMTF in the focused mode of
+ *  the restart policy and VSIDS in its stable mode ( MIXED ). */
+enum decide_t
+{
+    VSIDS, VMTF, MIXED
+};
+
+
+/** Limits of the work of a solver over all the calls of solve, 0 for
+ *  none. The seconds count from the construction of the solver, the
+ *  memory is the peak resident size of the whole process. */
+struct solver_limits
+{
+    size_t conflicts = 0;
+    size_t propagations = 0;
+    double seconds = 0;
+    size_t memory_mb = 0;
+};
+
+
+/** Parameters of the search, the solvers of a portfolio differ in them. */
+struct solver_config
+{
+    // Seed of the random tie-breaking of the initial variable order, 0
+    // keeps the order of the variable indices.
+    unsigned int seed = 0;
+
+    // Initial phase of all variables, val_un for random ones.
+    val_t phase = val_tt;
+
+    // The restart policy, luby_base is the unit of the Luby sequence.
+    restart_t restarts = LUBY;
+    unsigned int luby_base = 420;
+    double bump_step = 1.01;
+    decide_t heuristic = VSIDS;
+
+    // Decisions take the target phase, the value on the longest trail
+    // without a conflict since the last restart: 0 never, 1 in the stable
+    // mode of the restart policy, 2 always.
+    unsigned int target_phases = 1;
+
+    // The saved phases are reset after rephase_interval conflicts, again
+    // after twice as many more, and so on ( 0 never ).
+    size_t rephase_interval = 1000;
+
+    // Some rephasings seed the saved phases by local search, flipping
+    // about this fraction of the propagation work of the search since the
+    // previous one ( 0 never ).
+    double walk_effort = 0.1;
+
+    // Backtrack chronologically, one level, instead of backjumping over
+    // more than this many levels ( 0 never ).
+    size_t chrono_levels = 100;
+
+    // Keep the clauses of the formula in the cnf_t instead of copying
+    // them, the cnf_t has to outlive the solver. The binary clauses are
+    // read from formula_binaries if set, which has to outlive it as well.
+    bool share_formula = false;
+    const binary_lists *formula_binaries = nullptr;
+
+    // Simplify the clauses at level 0 now and then, spending about this
+    // fraction of the propagation work of the search on it.
+    bool inprocess = true;
+    double inprocess_effort = 0.1;
+
+    // Time the phases of the search, print a progress line every so many
+    // seconds ( 0 for none ).
+    bool profile = false;
+    double report_interval = 0;
+
+    solver_limits limits;
 };
 
 
@@ -212,16 +510,66 @@ struct clause_collection
 ///////////////////////////////////////////////////////////////////////////////
 
 
+/** CDCL solver. Besides solving a formula once, it can be used
+ *  incrementally: clauses may be added between calls of solve, which keep
+ *  the learnt clauses, activities and phases of the previous ones. */
 struct solver
 {
-    solver( cnf_t cnf );
-    sat_t solve();
+    solver( const cnf_t &cnf, const solver_config &config = {}
+          , proof_writer *proof = nullptr );
+
+    /** An empty formula over var_count variables. */
+    explicit solver( unsigned int var_count = 0, const solver_config &config = {} );
+
+    sat_t solve( const std::vector< lit_t > &assumptions = {}
+               , size_t max_conflicts = SIZE_MAX );
+
+    /** Adds a clause of the formula, new variables are added as needed.
+     *  Not supported when writing a proof. */
+    void add_clause( const clause_t &c );
+
+    /** Value of l in the model found by the last solve. */
+    val_t model_value( lit_t l )
+    {
+        return eval_lit( l );
+    }
+
+    /** After solve returned UNSAT under assumptions: the assumptions which
+     *  are contradictory together ( with the formula ). Empty when the
+     *  formula itself is unsatisfiable. */
+    std::vector< lit_t > core;
+
+    bool failed( lit_t a ) const
+    {
+        return std::find( core.begin(), core.end(), a ) != core.end();
+    }
+
+    void grow( unsigned int new_count );
+
+    // Set by another thread to make solve return UNKNOWN.
+    const std::atomic< bool > *stop = nullptr;
+
+    // When one of them is reached, solve returns UNKNOWN and sets
+    // limit_reached. They may be raised before solving again.
+    solver_limits limits;
+    bool limit_reached = false;
+
+    bool stopped() const
+    {
+        return stop && stop->load( std::memory_order_relaxed );
+    }
 
     // Formula 
 
     size_t var_count;
 
-    clause_collection clauses;
+    clause_arena clauses;
+
+    std::vector< lit_t > units;
+    bool empty_clause = false;
+
+    // The formula was found unsatisfiable.
+    bool inconsistent = false;
 
     // Picking literal
 
@@ -238,18 +586,72 @@ struct solver
     std::vector< lit_t > trail;
     std::vector< idx_t > decisions;
 
-    sidx_t decide( lit_t l );
+    void decide( lit_t l );
 
-    sidx_t assign( lit_t l );
+    void assign( lit_t l, reason_t why, sidx_t level );
+
+    void assign( lit_t l, reason_t why )
+    {
+        assign( l, why, decision_level );
+    }
+
+    sidx_t reason_level( lit_t l, reason_t why );
 
     void kill_trail( idx_t i );
 
     void backtrack( sidx_t dec_level );
 
+    // A backjump over more than chrono_levels levels only undoes the
+    // current one ( 0 never ). The trail is then no longer ordered by
+    // levels: literals are implied at the highest level of their reason.
+    size_t chrono_levels;
+
     // Unit propagation
 
-    literal_map< std::vector< idx_t > > watched_in;
-    std::deque< idx_t > unit_queue;
+    literal_map< std::vector< watcher > > watched_in;
+
+    // Trail positions up to which the long and binary clauses were
+    // propagated.
+    idx_t qhead = 0;
+    idx_t bin_qhead = 0;
+
+    // Binary clauses ( a, b ) live only here, b is in binary_in[ a ] and
+    // a in binary_in[ b ]. Those of a shared formula are in
+    // formula_binaries instead, until own_binaries copies them here.
+    literal_map< std::vector< lit_t > > binary_in;
+    const binary_lists *formula_binaries = nullptr;
+    std::pair< lit_t, lit_t > binary_conflict;
+
+    void add_binary( lit_t a, lit_t b, uint64_t id = 0 );
+
+    void own_binaries();
+
+    /** Number of the literals b with a binary clause ( a, b ). */
+    size_t implied_count( lit_t a ) const
+    {
+        size_t count = binary_in[ a ].size();
+        if ( formula_binaries )
+            count += ( *formula_binaries )[ a ].size();
+        return count;
+    }
+
+    /** The i-th of them, those of formula_binaries first. */
+    lit_t implied( lit_t a, idx_t i ) const
+    {
+        if ( formula_binaries )
+        {
+            clause_view shared = ( *formula_binaries )[ a ];
+            if ( i < shared.size() )
+                return shared[ i ];
+            i -= shared.size();
+        }
+        return binary_in[ a ][ i ];
+    }
+
+    template < typename lits_t >
+    sidx_t propagate_implied( lit_t l, const lits_t &others );
+
+    sidx_t propagate_binary( lit_t l );
 
     sidx_t update_watches( lit_t l );
 
@@ -260,35 +662,267 @@ struct solver
     literal_map< sidx_t > lit_level;
     sidx_t decision_level = 0;
 
-    literal_map< sidx_t > reason;
+    literal_map< reason_t > reason;
     literal_set to_resolve;
     literal_set learnt_lit;
 
+    void resolve_lit( clause_t& learnt_clause, lit_t l );
+
     void resolve_part( clause_t& learnt_clause
-                     , idx_t i_c
+                     , reason_t r_c
                      , lit_t r );
 
     std::pair< clause_t, idx_t > conflict_anal( sidx_t i_c );
 
-    idx_t learn( clause_t c );
+    sidx_t conflict_level( sidx_t i_c, lit_t &forced );
 
-    // EVSIDS
+    void rewatch( cref_t i_c, lit_t from, lit_t to );
 
+    // Learnt clause minimization
+
+    std::vector< lit_t > minimize_stack;
+    std::vector< lit_t > minimize_clear;
+
+    uint32_t abstract_level( sidx_t level )
+    {
+        return 1u << ( level & 31 );
+    }
+
+    void minimize( clause_t& learnt_clause );
+
+    bool lit_redundant( lit_t l, uint32_t levels );
+
+    reason_t learn( clause_t c );
+
+    // Learnt clause database
+
+    std::vector< size_t > level_stamp;
+    size_t lbd_stamp = 0;
+
+    size_t total_conflicts = 0;
+    size_t next_reduce = 2000;
+    size_t reduce_count = 0;
+
+    double clause_bump_step = 1.001;
+    double clause_bump_size = 1.0;
+
+    unsigned int compute_lbd( cref_t i_c );
+
+    unsigned int compute_lbd( const clause_t &c );
+
+    void bump_clause( cref_t i_c );
+
+    void reduce_db();
+
+    void collect_garbage();
+
+    // EVSIDS and VMTF, MIXED keeps both up to date.
+
+    decide_t heuristic;
     var_heap heap;
     double bump_step = 1.01;
     double bump_size = 1.0;
 
+    var_queue queue;
+    std::vector< var_t > queue_bumped;
+
+    bool keep_heap() const { return heuristic != VMTF; }
+    bool keep_queue() const { return heuristic != VSIDS; }
+    bool use_queue() const { return heuristic == VMTF || ( heuristic == MIXED && ! restarts.stable ); }
+
     void increase_bump();
 
     void bump( var_t var );
 
+    void bump_queue();
+
     // Restarts
-    size_t next_restart;
-    size_t conflict_count;
-    luby luby_gen;
+    restart_policy restarts;
+    unsigned int learnt_lbd = 0;
 
     void restart();
 
-    // Phase saving
+    bool pass_due() const;
+
+    sidx_t reuse_trail_level();
+
+    bool assign_units();
+
+    // Failed assumptions
+
+    std::vector< char > core_mark;
+
+    void analyze_final( lit_t a );
+
+    // Lookahead
+
+    long probe( lit_t l );
+
+    lit_t lookahead( const std::vector< lit_t > &cube, size_t candidates, bool &refuted );
+
+    // Inprocessing
+
+    bool inprocessing;
+    double inprocess_effort;
+    size_t next_inprocess = 2000;
+    size_t inprocess_count = 0;
+    size_t inprocess_ticks = 0;
+    var_t probe_cursor = 0;
+
+    // Level 0 trail literals up to which the clauses were cleaned, and
+    // up to which they were written to a DRAT proof as units.
+    idx_t cleaned_trail = 0;
+    idx_t proof_units = 0;
+
+    // The literal which a variable replaced by an equivalent one is equal
+    // to, 0 for the others. Empty until some variable is replaced.
+    std::vector< lit_t > substitute;
+
+    size_t ticks() const
+    {
+        return stats.propagations + stats.watcher_visits;
+    }
+
+    lit_t representative( lit_t l ) const
+    {
+        if ( substitute.empty() || substitute[ var_of_lit( l ) ] == 0 )
+            return l;
+        lit_t r = substitute[ var_of_lit( l ) ];
+        return l > 0 ? r : -r;
+    }
+
+    bool inprocess();
+
+    bool propagate_units();
+
+    void clean_level0();
+
+    void write_units();
+
+    bool probe_failed( size_t budget );
+
+    bool equivalent_literals();
+
+    bool vivify( size_t budget );
+
+    void replace_clause( cref_t c, const clause_t &lits );
+
+    void attach( cref_t c );
+
+    void detach( cref_t c );
+
+    void rebuild_watches();
+
+    // Clause sharing
+
+    clause_ring *share = nullptr;
+    unsigned int share_id = 0;
+    uint64_t share_cursor = 0;
+    clause_t import_buffer;
+
+    // The shared clauses are imported at every restart, and at least
+    // every import_interval conflicts.
+    static constexpr size_t import_interval = 500;
+    size_t next_import = import_interval;
+
+    void export_clause( const clause_t &c, unsigned int lbd );
+
+    bool import_shared();
+
+    bool import_clause( clause_t &c, unsigned int lbd );
+
+    // Phases. The saved phase of a variable is its last value, the target
+    // and best phases are its values on the longest trails without a
+    // conflict, since the last restart and since the last rephasing to the
+    // best phases. phases[ 0 ] keeps the initial phase.
     std::vector< val_t > phases;
+    std::vector< val_t > target_phases;
+    std::vector< val_t > best_phases;
+    size_t target_assigned = 0;
+    size_t best_assigned = 0;
+    unsigned int target_mode;
+    size_t rephase_interval;
+    size_t next_rephase;
+    std::mt19937 phase_random;
+
+    lit_t decision_literal( var_t v );
+
+    void update_phases();
+
+    void rephase();
+
+    double walk_effort;
+    size_t walk_ticks = 0;
+
+    void walk();
+
+    // Proof
+
+    proof_writer *proof;
+    bool lrat = false;
+
+    // Clause ids for LRAT: binary_ids is parallel to binary_in, unit_id
+    // is the unit clause which assigned a variable at level 0.
+    literal_map< std::vector< uint64_t > > binary_ids;
+    std::vector< uint64_t > unit_id;
+    std::vector< uint64_t > unit_clause_ids;
+    uint64_t empty_clause_id = 0;
+
+    std::vector< uint64_t > hints;
+    std::vector< char > hint_mark;
+    std::vector< var_t > hint_clear;
+    std::vector< std::pair< lit_t, bool > > hint_stack;
+
+    uint64_t binary_id( lit_t a, lit_t b );
+
+    uint64_t reason_id( reason_t why, lit_t l );
+
+    void justify( lit_t l );
+
+    void collect_hints( const clause_t &learnt_clause, sidx_t i_c );
+
+    void derive_unit( lit_t l, reason_t why );
+
+    void derive_empty();
+
+    // Statistics
+
+    solver_stats stats;
+
+    clock_type::time_point start_time;
+    double solve_seconds = 0;
+
+    // Indexed by phase_t, measured only when profiling.
+    bool profiling;
+    double phase_seconds[ PHASE_COUNT ] = {};
+
+    double *timer( phase_t phase )
+    {
+        return profiling ? &phase_seconds[ phase ] : nullptr;
+    }
+
+    // The clock is read only every poll_interval propagations, by poll.
+    static constexpr size_t poll_interval = 1 << 16;
+    size_t next_poll = 0;
+
+    bool poll();
+
+    double report_interval;
+    double next_report = 0;
+    size_t reports = 0;
+
+    // Where the previous progress line was, for the rates.
+    double reported_seconds = 0;
+    size_t reported_conflicts = 0;
+    size_t reported_propagations = 0;
+
+    void report( double now );
+
+    size_t binary_count() const;
+
+    void print_stats();
+
+    /** The statistics as a JSON object, its fields indented by indent
+     *  spaces. */
+    void write_json( std::ostream &out, int indent = 4 );
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+
+using clock_type = std::chrono::steady_clock;
+
+inline double seconds_since( clock_type::time_point start )
+{
+    return std::chrono::duration< double >( clock_type::now() - start ).count();
+}
+
+/** Adds the time from its construction to its destruction to *total. A
+ *  null total turns it off, then it does not read the clock at all. */
+struct scoped_timer
+{
+    double *total;
+    clock_type::time_point start;
+
+    explicit scoped_timer( double *total )
+        : total( total )
+    {
+        if ( total )
+            start = clock_type::now();
+    }
+
+    ~scoped_timer()
+    {
+        if ( total )
+            *total += seconds_since( start );
+    }
+
+    scoped_timer( const scoped_timer & ) = delete;
+    scoped_timer &operator=( const scoped_timer & ) = delete;
+};